@@ -0,0 +1,533 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//AnalyticalModel.cpp
+//
+//Class file for the closed-form latency model
+//
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include "AnalyticalModel.h"
+#include "AddressMapping.h"
+#include "PrintMacros.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+const double AnalyticalModel::MAX_OUTCOME_ERROR = 0.2;
+
+AnalyticalModel::AnalyticalModel() :
+	openRows(NUM_CHANS*NUM_RANKS*NUM_BANKS, NO_OPEN_ROW),
+	bankRates(NUM_CHANS*NUM_RANKS*NUM_BANKS, 0.0),
+	bankRateCycles(NUM_CHANS*NUM_RANKS*NUM_BANKS, 0),
+	busRates(NUM_CHANS, 0.0),
+	busRateCycles(NUM_CHANS, 0),
+	outstanding(NUM_CHANS, 0),
+	refreshPeriod(REFRESH_PERIOD/tCK),
+	firstRefresh(NUM_RANKS),
+	reads(0),
+	writes(0),
+	rowHits(0),
+	rowMisses(0),
+	rowConflicts(0),
+	totalReadLatency(0.0),
+	totalWriteLatency(0.0)
+{
+	Coefficients identity = {1.0, 1.0, 1.0, 0.0};
+	readCoefficients = identity;
+	writeCoefficients = identity;
+	// the same staggering as the MemoryController's refresh counters
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		firstRefresh[r] = (uint64_t)((REFRESH_PERIOD/tCK)/NUM_RANKS)*(r+1);
+	}
+}
+
+// rate in requests per cycle, decayed to cycle and then bumped by one arrival
+double AnalyticalModel::decayedRate(double &rate, uint64_t &lastCycle, uint64_t cycle)
+{
+	rate = rate * exp(-(double)(cycle - lastCycle) / RATE_WINDOW) + 1.0 / RATE_WINDOW;
+	lastCycle = cycle;
+	return rate;
+}
+
+AnalyticalModel::Features AnalyticalModel::classify(bool isWrite, uint64_t addr, uint64_t cycle)
+{
+	unsigned chan, rank, bank, row, col;
+	addressMapping(addr, chan, rank, bank, row, col);
+	size_t bankIndex = (chan*NUM_RANKS + rank)*NUM_BANKS + bank;
+
+	Features features;
+	features.cycle = cycle;
+
+	// a rank that refreshes in between has its rows closed again
+	bool refreshedSince = false;
+	double refreshWait = 0.0;
+	if (cycle >= firstRefresh[rank])
+	{
+		uint64_t phase = (cycle - firstRefresh[rank]) % refreshPeriod;
+		if (phase < tRFC)
+		{
+			refreshWait = tRFC - phase;
+		}
+		uint64_t lastRefresh = cycle - phase;
+		refreshedSince = bankRateCycles[bankIndex] < lastRefresh;
+	}
+	features.refresh = refreshWait;
+
+	double access = (isWrite ? WL : CL) + BL/2;
+	if (rowBufferPolicy == OpenPage && openRows[bankIndex] == row && !refreshedSince)
+	{
+		features.service = access;
+		features.outcome = ROW_HIT;
+		rowHits++;
+	}
+	else if (rowBufferPolicy == ClosePage || openRows[bankIndex] == NO_OPEN_ROW || refreshedSince)
+	{
+		features.service = tRCD + access;
+		features.outcome = ROW_MISS;
+		rowMisses++;
+	}
+	else
+	{
+		features.service = tRP + tRCD + access;
+		features.outcome = ROW_CONFLICT;
+		rowConflicts++;
+	}
+	openRows[bankIndex] = (rowBufferPolicy == OpenPage) ? row : NO_OPEN_ROW;
+
+	// M/D/1: Wq = rho / (2 (1 - rho)) * service time, for the bus and the bank
+	double burst = BL/2;
+	double busUtilization = min(0.95, decayedRate(busRates[chan], busRateCycles[chan], cycle) * burst);
+	double bankUtilization = min(0.95, decayedRate(bankRates[bankIndex], bankRateCycles[bankIndex], cycle) * features.service);
+	features.queueing = busUtilization / (2.0 * (1.0 - busUtilization)) * burst +
+		bankUtilization / (2.0 * (1.0 - bankUtilization)) * features.service;
+	return features;
+}
+
+double AnalyticalModel::estimate(const Coefficients &c, const Features &f)
+{
+	return max(1.0, c.service * f.service + c.queueing * f.queueing + c.refresh * f.refresh + c.constant);
+}
+
+bool AnalyticalModel::willAcceptTransaction(uint64_t addr) const
+{
+	unsigned chan, rank, bank, row, col;
+	addressMapping(addr, chan, rank, bank, row, col);
+	return outstanding[chan] < TRANS_QUEUE_DEPTH;
+}
+
+bool AnalyticalModel::willAcceptTransaction() const
+{
+	for (size_t c=0; c<NUM_CHANS; c++)
+	{
+		if (outstanding[c] >= TRANS_QUEUE_DEPTH)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// force skips the queue depth check, like a request the MemorySystem queues when the controller is full
+void AnalyticalModel::addTransaction(bool isWrite, uint64_t addr, uint64_t cycle, bool force)
+{
+	unsigned chan, rank, bank, row, col;
+	addressMapping(addr, chan, rank, bank, row, col);
+	if (!force && outstanding[chan] >= TRANS_QUEUE_DEPTH)
+	{
+		ERROR("Analytical model: channel "<<chan<<" is full");
+		abort();
+	}
+	Features features = classify(isWrite, addr, cycle);
+	double latency = estimate(isWrite ? writeCoefficients : readCoefficients, features);
+	inFlight.push(Completion(cycle + (uint64_t)(latency + 0.5), make_pair(addr, isWrite)));
+	outstanding[chan]++;
+	if (isWrite)
+	{
+		writes++;
+		totalWriteLatency += latency;
+	}
+	else
+	{
+		reads++;
+		totalReadLatency += latency;
+	}
+}
+
+// completions are reported with the channel as the system id, like the channels' own
+void AnalyticalModel::update(uint64_t cycle, TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone)
+{
+	while (!inFlight.empty() && inFlight.top().first <= cycle)
+	{
+		uint64_t addr = inFlight.top().second.first;
+		bool isWrite = inFlight.top().second.second;
+		inFlight.pop();
+		unsigned chan, rank, bank, row, col;
+		addressMapping(addr, chan, rank, bank, row, col);
+		outstanding[chan]--;
+		TransactionCompleteCB *done = isWrite ? writeDone : readDone;
+		if (done)
+		{
+			(*done)(chan, addr, cycle);
+		}
+	}
+}
+
+bool AnalyticalModel::isDrained() const
+{
+	return inFlight.empty();
+}
+
+void AnalyticalModel::printStats(ostream &out, uint64_t cycle) const
+{
+	uint64_t accesses = rowHits + rowMisses + rowConflicts;
+	unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+	double seconds = (double)cycle * tCK * 1E-9;
+	out << " =======================================================" << endl;
+	out << " ============ Analytical model statistics ==============" << endl;
+	out << "   Reads / Writes            : " << reads << " / " << writes << endl;
+	out << "   Bandwidth                 : " << ((seconds > 0) ? (double)(reads + writes) * bytesPerTransaction / (1024.0*1024.0*1024.0) / seconds : 0.0) << " GB/s" << endl;
+	out << "   Average read latency      : " << ((reads > 0) ? totalReadLatency / reads * tCK : 0.0) << " ns" << endl;
+	out << "   Average write latency     : " << ((writes > 0) ? totalWriteLatency / writes * tCK : 0.0) << " ns" << endl;
+	if (accesses > 0)
+	{
+		out << "   Row hits/misses/conflicts : " << 100.0 * rowHits / accesses << "% / " << 100.0 * rowMisses / accesses
+			<< "% / " << 100.0 * rowConflicts / accesses << "%" << endl;
+	}
+}
+
+/*
+ * Calibration: observe() is called for every request the detailed model
+ * accepts and observeCompletion() when it comes back; requests to the same
+ * address are matched up in order.
+ */
+void AnalyticalModel::observe(bool isWrite, uint64_t addr, uint64_t cycle)
+{
+	(isWrite ? observedWrites : observedReads)[addr].push_back(classify(isWrite, addr, cycle));
+}
+
+void AnalyticalModel::observeCompletion(bool isWrite, uint64_t addr, uint64_t cycle)
+{
+	map<uint64_t, deque<Features> > &observed = isWrite ? observedWrites : observedReads;
+	map<uint64_t, deque<Features> >::iterator it = observed.find(addr);
+	if (it == observed.end())
+	{
+		return;
+	}
+	Sample sample;
+	sample.features = it->second.front();
+	sample.latency = (double)(cycle - sample.features.cycle);
+	(isWrite ? writeSamples : readSamples).push_back(sample);
+	it->second.pop_front();
+	if (it->second.empty())
+	{
+		observed.erase(it);
+	}
+}
+
+/*
+ * Least squares on (S, Q, R, 1) -> latency with every coefficient kept at or
+ * above zero, since a negative one makes e.g. a row conflict faster than a
+ * hit: while the solution has a negative coefficient, the most negative one
+ * is pinned at zero and the others are refitted without it. A very light
+ * pull towards the current coefficients keeps a term that never varies in
+ * the samples (e.g. no request ever hit a refresh) at its old value rather
+ * than making the system singular.
+ */
+void AnalyticalModel::fit(const vector<Sample> &samples, Coefficients &coefficients)
+{
+	const unsigned N = 4;
+	double prior[N] = {coefficients.service, coefficients.queueing, coefficients.refresh, coefficients.constant};
+	double normal[N][N+1] = {{0}};
+	for (size_t i=0; i<samples.size(); i++)
+	{
+		const Features &f = samples[i].features;
+		double x[N] = {f.service, f.queueing, f.refresh, 1.0};
+		for (unsigned r=0; r<N; r++)
+		{
+			for (unsigned c=0; c<N; c++)
+			{
+				normal[r][c] += x[r] * x[c];
+			}
+			normal[r][N] += x[r] * samples[i].latency;
+		}
+	}
+	double lambda = 1E-6 * (normal[0][0] + normal[1][1] + normal[2][2] + normal[3][3]) + 1E-9;
+	for (unsigned r=0; r<N; r++)
+	{
+		normal[r][r] += lambda;
+		normal[r][N] += lambda * prior[r];
+	}
+
+	bool pinned[N] = {false, false, false, false};
+	double solution[N];
+	while (true)
+	{
+		double a[N][N+1];
+		for (unsigned r=0; r<N; r++)
+		{
+			for (unsigned k=0; k<=N; k++)
+			{
+				a[r][k] = pinned[r] ? 0.0 : normal[r][k];
+			}
+		}
+		// a pinned term is zero, so it drops out of the other equations
+		for (unsigned r=0; r<N; r++)
+		{
+			if (pinned[r])
+			{
+				for (unsigned k=0; k<N; k++)
+				{
+					a[k][r] = 0.0;
+				}
+				a[r][r] = 1.0;
+			}
+		}
+
+		// gaussian elimination with partial pivoting
+		for (unsigned c=0; c<N; c++)
+		{
+			unsigned pivot = c;
+			for (unsigned r=c+1; r<N; r++)
+			{
+				if (fabs(a[r][c]) > fabs(a[pivot][c]))
+				{
+					pivot = r;
+				}
+			}
+			for (unsigned k=0; k<=N; k++)
+			{
+				swap(a[c][k], a[pivot][k]);
+			}
+			for (unsigned r=0; r<N; r++)
+			{
+				if (r != c)
+				{
+					double factor = a[r][c] / a[c][c];
+					for (unsigned k=c; k<=N; k++)
+					{
+						a[r][k] -= factor * a[c][k];
+					}
+				}
+			}
+		}
+
+		unsigned mostNegative = N;
+		for (unsigned r=0; r<N; r++)
+		{
+			solution[r] = a[r][N] / a[r][r];
+			if (solution[r] < 0.0 && (mostNegative == N || solution[r] < solution[mostNegative]))
+			{
+				mostNegative = r;
+			}
+		}
+		if (mostNegative == N)
+		{
+			break;
+		}
+		pinned[mostNegative] = true;
+	}
+	coefficients.service = solution[0];
+	coefficients.queueing = solution[1];
+	coefficients.refresh = solution[2];
+	coefficients.constant = solution[3];
+}
+
+void AnalyticalModel::outcomeErrors(const vector<Sample> &samples, const Coefficients &c, OutcomeError errors[])
+{
+	for (size_t o=0; o<NUM_ROW_OUTCOMES; o++)
+	{
+		OutcomeError empty = {0, 0.0, 0.0, 0.0};
+		errors[o] = empty;
+	}
+	for (size_t i=0; i<samples.size(); i++)
+	{
+		OutcomeError &error = errors[samples[i].features.outcome];
+		double estimateCycles = estimate(c, samples[i].features);
+		error.samples++;
+		error.measured += samples[i].latency;
+		error.predicted += estimateCycles;
+		error.absoluteError += fabs(estimateCycles - samples[i].latency);
+	}
+}
+
+// false when the fit only gets the overall mean right: its mean latency for
+// row hits, misses or conflicts is off by more than MAX_OUTCOME_ERROR (an
+// outcome with under 1% of the samples is too rare to judge by)
+bool AnalyticalModel::fitsOutcomes(const vector<Sample> &samples, const Coefficients &c)
+{
+	OutcomeError errors[NUM_ROW_OUTCOMES];
+	outcomeErrors(samples, c, errors);
+	for (size_t o=0; o<NUM_ROW_OUTCOMES; o++)
+	{
+		if (errors[o].samples * 100 >= samples.size() && fabs(errors[o].predicted - errors[o].measured) > MAX_OUTCOME_ERROR * errors[o].measured)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void AnalyticalModel::reportError(ostream &report, const char *kind, const vector<Sample> &samples, const Coefficients &c)
+{
+	double measured=0.0, predicted=0.0, absoluteError=0.0;
+	for (size_t i=0; i<samples.size(); i++)
+	{
+		double estimateCycles = estimate(c, samples[i].features);
+		measured += samples[i].latency;
+		predicted += estimateCycles;
+		absoluteError += fabs(estimateCycles - samples[i].latency);
+	}
+	size_t n = samples.size();
+	report << "   " << kind << " (" << n << " samples): latency = " << c.service << "*S + " << c.queueing << "*Q + "
+		<< c.refresh << "*R + " << c.constant << endl;
+	if (n > 0)
+	{
+		report << "      mean latency detailed " << measured / n * tCK << " ns, analytical " << predicted / n * tCK
+			<< " ns (" << 100.0 * (predicted - measured) / measured << "%), mean absolute error per request "
+			<< absoluteError / n * tCK << " ns (" << 100.0 * absoluteError / measured << "%)" << endl;
+	}
+
+	// the same by row buffer outcome, where a fit that only gets the mean right shows up
+	const char *outcomeNames[NUM_ROW_OUTCOMES] = {"row hits     ", "row misses   ", "row conflicts"};
+	OutcomeError errors[NUM_ROW_OUTCOMES];
+	outcomeErrors(samples, c, errors);
+	for (size_t o=0; o<NUM_ROW_OUTCOMES; o++)
+	{
+		const OutcomeError &error = errors[o];
+		if (error.samples == 0)
+		{
+			continue;
+		}
+		report << "      " << outcomeNames[o] << " (" << error.samples << "): detailed " << error.measured / error.samples * tCK
+			<< " ns, analytical " << error.predicted / error.samples * tCK << " ns (" << 100.0 * (error.predicted - error.measured) / error.measured
+			<< "%), mean absolute error " << error.absoluteError / error.samples * tCK << " ns ("
+			<< 100.0 * error.absoluteError / error.measured << "%)" << endl;
+	}
+}
+
+// fits both coefficient sets to what was observed; false if there was
+// nothing to fit or a fit misses the mean of some row buffer outcome
+bool AnalyticalModel::calibrate(ostream &report)
+{
+	report << "== Analytical model calibration ==" << endl;
+	if (readSamples.empty() && writeSamples.empty())
+	{
+		report << "   no completed requests were observed" << endl;
+		return false;
+	}
+	report << "  before fitting:" << endl;
+	reportError(report, "reads ", readSamples, readCoefficients);
+	reportError(report, "writes", writeSamples, writeCoefficients);
+	if (!readSamples.empty())
+	{
+		fit(readSamples, readCoefficients);
+	}
+	if (!writeSamples.empty())
+	{
+		fit(writeSamples, writeCoefficients);
+	}
+	report << "  after fitting:" << endl;
+	reportError(report, "reads ", readSamples, readCoefficients);
+	reportError(report, "writes", writeSamples, writeCoefficients);
+	if (!fitsOutcomes(readSamples, readCoefficients) || !fitsOutcomes(writeSamples, writeCoefficients))
+	{
+		report << "   the fit is more than " << 100.0 * MAX_OUTCOME_ERROR << "% off for row hits, misses or conflicts,"
+			<< " so the model doesn't describe this traffic; the coefficients are not saved" << endl;
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Coefficient files are KEY=value lines (READ_SERVICE, ..., WRITE_CONSTANT);
+ * ';' starts a comment, as in the ini files.
+ */
+void AnalyticalModel::saveCoefficients(const string &filename) const
+{
+	ofstream out(filename.c_str());
+	if (!out.is_open())
+	{
+		ERROR("Could not write analytical model coefficients to '"<<filename<<"'");
+		exit(-1);
+	}
+	const Coefficients *sets[] = {&readCoefficients, &writeCoefficients};
+	const char *names[] = {"READ", "WRITE"};
+	out << "; analytical model coefficients fitted by DRAMSim2 --calibrate" << endl;
+	out.precision(17);
+	for (size_t i=0; i<2; i++)
+	{
+		out << names[i] << "_SERVICE=" << sets[i]->service << endl;
+		out << names[i] << "_QUEUEING=" << sets[i]->queueing << endl;
+		out << names[i] << "_REFRESH=" << sets[i]->refresh << endl;
+		out << names[i] << "_CONSTANT=" << sets[i]->constant << endl;
+	}
+}
+
+bool AnalyticalModel::loadCoefficients(const string &filename)
+{
+	ifstream in(filename.c_str());
+	if (!in.is_open())
+	{
+		ERROR("Could not open analytical model coefficients '"<<filename<<"'");
+		return false;
+	}
+	map<string, double *> keys;
+	const char *names[] = {"READ", "WRITE"};
+	Coefficients *sets[] = {&readCoefficients, &writeCoefficients};
+	for (size_t i=0; i<2; i++)
+	{
+		keys[string(names[i]) + "_SERVICE"] = &sets[i]->service;
+		keys[string(names[i]) + "_QUEUEING"] = &sets[i]->queueing;
+		keys[string(names[i]) + "_REFRESH"] = &sets[i]->refresh;
+		keys[string(names[i]) + "_CONSTANT"] = &sets[i]->constant;
+	}
+	string line;
+	while (getline(in, line))
+	{
+		size_t equals = line.find('=');
+		if (line.length() == 0 || line[0] == ';' || equals == string::npos)
+		{
+			continue;
+		}
+		string key = line.substr(0, equals);
+		map<string, double *>::iterator it = keys.find(key);
+		if (it == keys.end())
+		{
+			ERROR("Unknown key '"<<key<<"' in '"<<filename<<"'");
+			return false;
+		}
+		*it->second = atof(line.substr(equals+1).c_str());
+	}
+	return true;
+}
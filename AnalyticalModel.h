@@ -0,0 +1,188 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef ANALYTICALMODEL_H
+#define ANALYTICALMODEL_H
+
+//AnalyticalModel.h
+//
+//Header file for the closed-form latency model that can stand in for the
+//cycle-accurate channels
+//
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <string>
+#include <ostream>
+#include "SystemConfiguration.h"
+#include "Callback.h"
+
+using std::string;
+using std::vector;
+
+namespace DRAMSim
+{
+/*
+ * AnalyticalModel: estimates the latency of each request from the ini timing
+ * parameters instead of scheduling DRAM commands. A request's latency (in
+ * memory cycles) is
+ *
+ *   service * S + queueing * Q + refresh * R + constant
+ *
+ *   S  access time for a row hit, a miss to a precharged bank or a row
+ *      conflict (tRP + tRCD + CL + BL/2 and so on); rows are tracked per bank
+ *      under the page policy
+ *   Q  M/D/1 waiting time on the data bus plus on the bank, with both
+ *      utilizations taken from exponentially decaying arrival rates
+ *   R  what is left of a refresh when the request lands in one; ranks are
+ *      refreshed on the same staggered schedule as the MemoryController's
+ *
+ * The coefficients start out at 1,1,1,0 and are meant to be fitted against
+ * the detailed model: observe() and observeCompletion() collect (S,Q,R,
+ * measured latency) samples from a detailed run and calibrate() fits reads
+ * and writes separately by least squares, with every coefficient kept at or
+ * above zero, and reports the fit's error overall and per row buffer
+ * outcome.
+ *
+ * As an engine it accepts up to TRANS_QUEUE_DEPTH requests per channel and
+ * completes each one after its estimated latency.
+ */
+class AnalyticalModel
+{
+public:
+	struct Coefficients
+	{
+		double service;
+		double queueing;
+		double refresh;
+		double constant;
+	};
+
+	AnalyticalModel();
+
+	bool willAcceptTransaction(uint64_t addr) const;
+	bool willAcceptTransaction() const;
+	void addTransaction(bool isWrite, uint64_t addr, uint64_t cycle, bool force=false);
+	void update(uint64_t cycle, TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone);
+	bool isDrained() const;
+	void printStats(std::ostream &out, uint64_t cycle) const;
+
+	void observe(bool isWrite, uint64_t addr, uint64_t cycle);
+	void observeCompletion(bool isWrite, uint64_t addr, uint64_t cycle);
+	bool calibrate(std::ostream &report);
+
+	bool loadCoefficients(const string &filename);
+	void saveCoefficients(const string &filename) const;
+
+	Coefficients readCoefficients;
+	Coefficients writeCoefficients;
+
+private:
+	enum RowOutcome
+	{
+		ROW_HIT,
+		ROW_MISS,
+		ROW_CONFLICT,
+		NUM_ROW_OUTCOMES
+	};
+	// the terms of the latency equation for one request
+	struct Features
+	{
+		double service;
+		double queueing;
+		double refresh;
+		uint64_t cycle;
+		RowOutcome outcome;
+	};
+	struct Sample
+	{
+		Features features;
+		double latency;
+	};
+	// measured and predicted latency summed over the samples of one row buffer outcome
+	struct OutcomeError
+	{
+		size_t samples;
+		double measured;
+		double predicted;
+		double absoluteError;
+	};
+
+	// exponential decay time constant of the arrival rates, in cycles
+	static const unsigned RATE_WINDOW = 1000;
+	static const unsigned NO_OPEN_ROW = (unsigned)-1;
+	// how far off a fit's mean latency for any one row buffer outcome may be
+	static const double MAX_OUTCOME_ERROR;
+
+	Features classify(bool isWrite, uint64_t addr, uint64_t cycle);
+	double decayedRate(double &rate, uint64_t &lastCycle, uint64_t cycle);
+	static double estimate(const Coefficients &coefficients, const Features &features);
+	static void fit(const vector<Sample> &samples, Coefficients &coefficients);
+	static void outcomeErrors(const vector<Sample> &samples, const Coefficients &coefficients, OutcomeError errors[]);
+	static bool fitsOutcomes(const vector<Sample> &samples, const Coefficients &coefficients);
+	static void reportError(std::ostream &report, const char *kind, const vector<Sample> &samples, const Coefficients &coefficients);
+
+	// per bank (channel, rank, bank)
+	vector<unsigned> openRows;
+	vector<double> bankRates;
+	vector<uint64_t> bankRateCycles;
+	// per channel
+	vector<double> busRates;
+	vector<uint64_t> busRateCycles;
+	vector<unsigned> outstanding;
+
+	uint64_t refreshPeriod;
+	vector<uint64_t> firstRefresh;
+
+	// (completion cycle, (address, isWrite)) of the requests in flight
+	typedef std::pair<uint64_t, std::pair<uint64_t, bool> > Completion;
+	std::priority_queue<Completion, vector<Completion>, std::greater<Completion> > inFlight;
+
+	// calibration: requests seen going into the detailed model, by address
+	std::map<uint64_t, std::deque<Features> > observedReads;
+	std::map<uint64_t, std::deque<Features> > observedWrites;
+	vector<Sample> readSamples;
+	vector<Sample> writeSamples;
+
+	// stats
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t rowHits;
+	uint64_t rowMisses;
+	uint64_t rowConflicts;
+	double totalReadLatency;
+	double totalWriteLatency;
+};
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//AsyncLog.cpp
+//
+//Class file for the stream buffer behind dramsim_log
+//
+
+#include <iostream>
+#include <sched.h>
+#include "AsyncLog.h"
+#include "PrintMacros.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+// records on the ring at most (the byte budget is usually the limit)
+static const unsigned LOG_RING_BITS = 16;
+// a record is handed over once it gets this long even without a flush
+static const size_t MAX_RECORD_BYTES = 64*1024;
+static const unsigned LOG_WRITER_SLEEP_US = 200;
+
+AsyncLogBuffer::AsyncLogBuffer() :
+	RingWriter<string *>(LOG_RING_BITS, LOG_WRITER_SLEEP_US),
+	droppedRecords(0),
+	queuedBytes(0),
+	budgetBytes(0),
+	policy(Block)
+{}
+
+AsyncLogBuffer::~AsyncLogBuffer()
+{
+	close();
+}
+
+bool AsyncLogBuffer::open(const string &filename, size_t budgetBytes_, FullPolicy policy_)
+{
+	close();
+	file.open(filename.c_str(), ios_base::out | ios_base::trunc);
+	if (!file)
+	{
+		return false;
+	}
+	budgetBytes = budgetBytes_;
+	policy = policy_;
+	droppedRecords = 0;
+	if (!start())
+	{
+		ERROR("Cannot start the log writer thread");
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+//hands over what is left, waits for the writer to write everything and closes the file
+void AsyncLogBuffer::close()
+{
+	if (!isRunning())
+	{
+		return;
+	}
+	publish();
+	stop();
+	file.close();
+	if (droppedRecords > 0)
+	{
+		cerr << "WARNING: dropped " << droppedRecords << " log records because the log couldn't be written fast enough" << endl;
+	}
+}
+
+AsyncLogBuffer::int_type AsyncLogBuffer::overflow(int_type c)
+{
+	if (isRunning() && c != traits_type::eof())
+	{
+		record.push_back(traits_type::to_char_type(c));
+		if (record.size() >= MAX_RECORD_BYTES)
+		{
+			publish();
+		}
+	}
+	return traits_type::not_eof(c);
+}
+
+streamsize AsyncLogBuffer::xsputn(const char *s, streamsize n)
+{
+	if (isRunning())
+	{
+		record.append(s, n);
+		if (record.size() >= MAX_RECORD_BYTES)
+		{
+			publish();
+		}
+	}
+	return n;
+}
+
+int AsyncLogBuffer::sync()
+{
+	publish();
+	return 0;
+}
+
+void AsyncLogBuffer::publish()
+{
+	if (record.empty())
+	{
+		return;
+	}
+	size_t size = record.size();
+	string *published = new string();
+	published->swap(record);
+	record.reserve(size);
+
+	// a record bigger than the whole budget still goes through once the ring is empty
+	while (queuedBytes > 0 && queuedBytes + size > budgetBytes)
+	{
+		if (policy == Drop)
+		{
+			droppedRecords++;
+			delete published;
+			return;
+		}
+		sched_yield();
+	}
+	__sync_fetch_and_add(&queuedBytes, size);
+	while (!push(published))
+	{
+		if (policy == Drop)
+		{
+			__sync_fetch_and_sub(&queuedBytes, size);
+			droppedRecords++;
+			delete published;
+			return;
+		}
+		sched_yield();
+	}
+}
+
+void AsyncLogBuffer::write(string *&published)
+{
+	file.write(published->data(), published->size());
+	__sync_fetch_and_sub(&queuedBytes, published->size());
+	delete published;
+}
+
+void AsyncLogBuffer::caughtUp()
+{
+	file.flush();
+}
+}
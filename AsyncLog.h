@@ -0,0 +1,95 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+//AsyncLog.h
+//
+//Header file for the stream buffer behind dramsim_log
+//
+
+#include <streambuf>
+#include <fstream>
+#include <string>
+#include "RingWriter.h"
+
+using std::string;
+
+namespace DRAMSim
+{
+/*
+ * A stream buffer that hands what is written to it over to a writer thread
+ * instead of writing to the file on the simulation thread. Text collects
+ * into a record until the stream is flushed (every PRINT ends with endl);
+ * the record then goes on the writer's lock-free ring.
+ *
+ * At most budgetBytes of records wait for the writer. When a record doesn't
+ * fit, the Block policy waits for the writer to catch up (nothing is lost)
+ * and the Drop policy throws it away and counts it. Until open() is called
+ * everything written is discarded.
+ */
+class AsyncLogBuffer : public std::streambuf, private RingWriter<string *>
+{
+public:
+	enum FullPolicy
+	{
+		Block,
+		Drop
+	};
+
+	AsyncLogBuffer();
+	virtual ~AsyncLogBuffer();
+	bool open(const string &filename, size_t budgetBytes, FullPolicy policy);
+	void close();
+
+	uint64_t droppedRecords;
+
+protected:
+	virtual int_type overflow(int_type c);
+	virtual std::streamsize xsputn(const char *s, std::streamsize n);
+	virtual int sync();
+
+private:
+	void write(string *&published);
+	void caughtUp();
+	void publish();
+
+	string record;
+	// bytes in the records on the ring, only changed with __sync builtins
+	volatile size_t queuedBytes;
+	size_t budgetBytes;
+	FullPolicy policy;
+
+	std::ofstream file;
+};
+}
+
+#endif
@@ -41,6 +41,7 @@
 //
 
 #include "BankState.h"
+#include "Checkpoint.h"
 
 using namespace std;
 using namespace DRAMSim;
@@ -86,3 +87,31 @@ void BankState::print()
 	PRINT("    nextPrecharge  : " << nextPrecharge );
 	PRINT("    nextPowerUp    : " << nextPowerUp );
 }
+
+void BankState::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_BANK_STATE);
+	checkpoint.write(currentBankState);
+	checkpoint.write(openRowAddress);
+	checkpoint.write(nextRead);
+	checkpoint.write(nextWrite);
+	checkpoint.write(nextActivate);
+	checkpoint.write(nextPrecharge);
+	checkpoint.write(nextPowerUp);
+	checkpoint.write(lastCommand);
+	checkpoint.write(stateChangeCountdown);
+}
+
+void BankState::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readSection(CHECKPOINT_BANK_STATE);
+	checkpoint.read(currentBankState);
+	checkpoint.read(openRowAddress);
+	checkpoint.read(nextRead);
+	checkpoint.read(nextWrite);
+	checkpoint.read(nextActivate);
+	checkpoint.read(nextPrecharge);
+	checkpoint.read(nextPowerUp);
+	checkpoint.read(lastCommand);
+	checkpoint.read(stateChangeCountdown);
+}
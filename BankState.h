@@ -48,6 +48,9 @@
 
 namespace DRAMSim
 {
+class CheckpointWriter;
+class CheckpointReader;
+
 enum CurrentBankState
 {
 	Idle,
@@ -76,6 +79,8 @@ public:
 	//Functions
 	BankState(ostream &dramsim_log_);
 	void print();
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
 };
 }
 
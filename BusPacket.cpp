@@ -55,7 +55,13 @@ BusPacket::BusPacket(BusPacketType packtype, uint64_t physicalAddr,
 	bank(b),
 	rank(r),
 	physicalAddress(physicalAddr),
-	data(dat)
+	data(dat),
+	timeEnqueued(0),
+	timeActivated(0),
+	timeIssued(0),
+	refreshEnqueued(0),
+	refreshActivated(0),
+	refreshIssued(0)
 {}
 
 void BusPacket::print(uint64_t currentClockCycle, bool dataStart)
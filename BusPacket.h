@@ -64,6 +64,16 @@ public:
 	unsigned rank;
 	uint64_t physicalAddress;
 	void *data;
+	// for the read latency breakdown: when a column command reached the
+	// command queue, when its ACT went out (or the enqueue time, for a row
+	// hit) and when it went out itself, with the rank's refresh-blocked cycle
+	// count at each (see MemoryController::refreshBlockedCycles)
+	uint64_t timeEnqueued;
+	uint64_t timeActivated;
+	uint64_t timeIssued;
+	uint64_t refreshEnqueued;
+	uint64_t refreshActivated;
+	uint64_t refreshIssued;
 
 	//Functions
 	BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r, unsigned b, void *dat, ostream &dramsim_log_);
@@ -32,7 +32,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <vector>
 #include <string>
 
@@ -47,30 +50,37 @@ using std::string;
  * 	the names of each field and prints it out to a header before printing
  * 	the CSV data below. 
  *
- * 	Note: the first finalize() will not print the values out, only the headers.
- * 	One way to fix this problem would be to use a sstringstream (or something) 
- * 	to buffer out the values and flush them all in one go instead of passing them 
- * 	directly to the underlying stream as is the case now. 
+ * 	The field names are only taken from the first row; after that they are
+ * 	skipped (an IndexedName is only formatted into a string when it is
+ * 	needed for the header). The values of a row go into a row buffer that is
+ * 	sized by the first row and written out in one go by finalize(), so the
+ * 	first finalize() prints the header followed by the first row.
+ *
+ * 	Anything written to getOutputStream() while a row is being filled in
+ * 	comes out after that row.
  *
  * 	Example usage: 
  *
  * 	CSVWriter sw(cout);               // send output to cout
- * 	sw <<"Bandwidth" << 0.5; // value ignored
- * 	sw <<"Latency" << 5;     // value ignored
- * 	sw.finalize();                      // flush the header 
+ * 	sw <<"Bandwidth" << 0.5;
+ * 	sw <<"Latency" << 5;
+ * 	sw.finalize();                      // header and first line
  * 	sw <<"Bandwidth" << 1.5; // field name ignored
  * 	sw <<"Latency" << 15;     // field name ignored
  * 	sw.finalize(); 							// values printed to csv line
- * 	sw <<"Bandwidth" << 2.5; // field name ignored
- * 	sw <<"Latency" << 25;     // field name ignored
- * 	sw.finalize(); 							// values printed to csv line
  *
  * 	The output of this example will be: 
  *
- * 	Bandwidth,Latency
- * 	1.5,15
- * 	2.5,25
+ * 	Bandwidth,Latency,
+ * 	0.5,5,
+ * 	1.5,15,
  *
+ * 	With setBinaryOutput() every row also goes to a second stream in binary
+ * 	form (see visb2csv.py for a converter back to CSV):
+ *
+ * 	uint32_t magic ("DSVB"), uint32_t version, uint32_t number of columns,
+ * 	then for every column a uint32_t length and the name (no terminator),
+ * 	then one row after another, each a double per column in header order.
  */
 
 
@@ -78,10 +88,15 @@ namespace DRAMSim {
 
 	class CSVWriter {
 		public :
+		static const uint32_t BINARY_MAGIC = 0x42565344; // "DSVB"
+		static const uint32_t BINARY_VERSION = 1;
+
 		struct IndexedName {
 			static const size_t MAX_TMP_STR = 64; 
 			static const unsigned SINGLE_INDEX_LEN = 4; 
-			string str; 
+			const char *baseName;
+			unsigned numIndices;
+			unsigned indices[3];
 
 			// functions 
 			static bool isNameTooLong(const char *baseName, unsigned numIndices)
@@ -96,34 +111,48 @@ namespace DRAMSim {
 					exit(-1); 
 				}
 			}
-			IndexedName(const char *baseName, unsigned channel)
+			IndexedName(const char *baseName_, unsigned channel) : baseName(baseName_), numIndices(1)
 			{
-				checkNameLength(baseName,1);
-				char tmp_str[MAX_TMP_STR]; 
-				snprintf(tmp_str, MAX_TMP_STR,"%s[%u]", baseName, channel); 
-				str = string(tmp_str); 
+				indices[0] = channel;
 			}
-			IndexedName(const char *baseName, unsigned channel, unsigned rank)
+			IndexedName(const char *baseName_, unsigned channel, unsigned rank) : baseName(baseName_), numIndices(2)
 			{
-				checkNameLength(baseName,2);
-				char tmp_str[MAX_TMP_STR]; 
-				snprintf(tmp_str, MAX_TMP_STR,"%s[%u][%u]", baseName, channel, rank); 
-				str = string(tmp_str); 
+				indices[0] = channel;
+				indices[1] = rank;
 			}
-			IndexedName(const char *baseName, unsigned channel, unsigned rank, unsigned bank)
+			IndexedName(const char *baseName_, unsigned channel, unsigned rank, unsigned bank) : baseName(baseName_), numIndices(3)
 			{
-				checkNameLength(baseName,3);
-				char tmp_str[MAX_TMP_STR]; 
-				snprintf(tmp_str, MAX_TMP_STR,"%s[%u][%u][%u]", baseName, channel, rank, bank); 
-				str = string(tmp_str);
+				indices[0] = channel;
+				indices[1] = rank;
+				indices[2] = bank;
+			}
+			string str() const
+			{
+				checkNameLength(baseName,numIndices);
+				string name(baseName);
+				char index[16];
+				for (unsigned i=0; i<numIndices; i++)
+				{
+					snprintf(index, sizeof(index), "[%u]", indices[i]);
+					name.append(index);
+				}
+				return name; 
 			}
 
 		};
 		// where the output will eventually go 
 		ostream &output; 
+		// binary copy of every row (NULL when off)
+		ostream *binaryOutput;
 		vector<string> fieldNames; 
 		bool finalized; 
 		unsigned idx; 
+		// the row being filled in and whether each value was an integer
+		vector<double> values;
+		vector<bool> isInteger;
+		// getOutputStream() text waiting for the row to be written
+		std::stringstream trailer;
+		string lineBuffer;
 		public: 
 
 		// Functions
@@ -136,22 +165,23 @@ namespace DRAMSim {
 				{
 					output << fieldNames[i] << ",";
 				}
-				output << std::endl << std::flush;
+				output << std::endl;
+				if (binaryOutput)
+				{
+					writeBinaryHeader();
+				}
 				finalized=true; 
 			}
-			else
+			else if (idx < fieldNames.size()) 
 			{
-				if (idx < fieldNames.size()) 
-				{
-					printf(" Number of fields doesn't match values (fields=%u, values=%u), check each value has a field name before it\n", idx, (unsigned)fieldNames.size());
-				}
-				idx=0; 
-				output << std::endl; 
+				printf(" Number of fields doesn't match values (fields=%u, values=%u), check each value has a field name before it\n", idx, (unsigned)fieldNames.size());
 			}
+			writeRow();
+			idx=0; 
 		}
 
 		// Constructor 
-		CSVWriter(ostream &_output) : output(_output), finalized(false), idx(0)
+		CSVWriter(ostream &_output) : output(_output), binaryOutput(NULL), finalized(false), idx(0)
 		{}
 
 		// Insertion operators for field names
@@ -159,7 +189,6 @@ namespace DRAMSim {
 		{
 			if (!finalized)
 			{
-//				cout <<"Adding "<<name<<endl;
 				fieldNames.push_back(string(name));
 			}
 			return *this; 
@@ -178,46 +207,118 @@ namespace DRAMSim {
 		{
 			if (!finalized)
 			{
-//				cout <<"Adding "<<indexedName.str<<endl;
-				fieldNames.push_back(indexedName.str);
+				fieldNames.push_back(indexedName.str());
 			}
 			return *this; 
 		}
 		
 		bool isFinalized()
 		{
-//			printf("obj=%p", this); 
 			return finalized; 
 		}
+
+		// start over with the header, e.g. once the output has been reopened
+		void reset()
+		{
+			fieldNames.clear();
+			finalized=false;
+			idx=0;
+			values.clear();
+			isInteger.clear();
+			trailer.str("");
+		}
+
+		// also write every row to binaryOutput from the next header on (NULL to stop)
+		void setBinaryOutput(ostream *binaryOutput_)
+		{
+			binaryOutput = binaryOutput_;
+		}
 		
 		ostream &getOutputStream()
 		{
-			return output; 
+			return trailer; 
 		}
 		// Insertion operators for value types 
-		// All of the other types just need to pass through to the underlying
-		// ofstream, so just write this small wrapper function to make the
-		// whole thing less verbose
-#define ADD_TYPE(T) \
+		// All of the other types just go into the row buffer, so just write
+		// this small wrapper function to make the whole thing less verbose
+#define ADD_TYPE(T, INTEGER) \
 		CSVWriter &operator<<(T value) \
 		{                                \
-			if (finalized)                \
-			{                             \
-				output << value <<",";     \
-				idx++;                     \
-			}                             \
+			addValue((double)value, INTEGER); \
 			return *this;                 \
 		}                      
 
-	ADD_TYPE(int);
-	ADD_TYPE(unsigned); 
-	ADD_TYPE(long);
-	ADD_TYPE(uint64_t);
-	ADD_TYPE(float);
-	ADD_TYPE(double);
+	ADD_TYPE(int, true);
+	ADD_TYPE(unsigned, true); 
+	ADD_TYPE(long, true);
+	ADD_TYPE(uint64_t, true);
+	ADD_TYPE(float, false);
+	ADD_TYPE(double, false);
 
-	//disable copy constructor and assignment operator
 	private:
+		void addValue(double value, bool integer)
+		{
+			if (idx < values.size())
+			{
+				values[idx] = value;
+				isInteger[idx] = integer;
+			}
+			else
+			{
+				values.push_back(value);
+				isInteger.push_back(integer);
+			}
+			idx++;
+		}
+
+		// same formatting as an ostream with the default flags
+		void writeRow()
+		{
+			char number[32];
+			lineBuffer.clear();
+			for (unsigned i=0; i<idx; i++)
+			{
+				if (isInteger[i])
+				{
+					snprintf(number, sizeof(number), "%lld,", (long long)values[i]);
+				}
+				else
+				{
+					snprintf(number, sizeof(number), "%g,", values[i]);
+				}
+				lineBuffer.append(number);
+			}
+			lineBuffer.append("\n");
+			output.write(lineBuffer.data(), lineBuffer.size());
+			if (binaryOutput)
+			{
+				// a short row is padded so the records stay fixed size
+				for (unsigned i=idx; i<fieldNames.size(); i++)
+				{
+					addValue(std::numeric_limits<double>::quiet_NaN(), false);
+				}
+				binaryOutput->write((const char *)&values[0], fieldNames.size() * sizeof(double));
+			}
+			if (trailer.tellp() > 0)
+			{
+				output << trailer.str();
+				trailer.str("");
+			}
+		}
+
+		void writeBinaryHeader()
+		{
+			uint32_t header[3] = {BINARY_MAGIC, BINARY_VERSION, (uint32_t)fieldNames.size()};
+			binaryOutput->write((const char *)header, sizeof(header));
+			for (size_t i=0; i<fieldNames.size(); i++)
+			{
+				uint32_t length = fieldNames[i].length();
+				binaryOutput->write((const char *)&length, sizeof(length));
+				binaryOutput->write(fieldNames[i].data(), length);
+			}
+		}
+
+	//disable copy constructor and assignment operator
 		CSVWriter(const CSVWriter &); 
 		CSVWriter &operator=(const CSVWriter &);
 		
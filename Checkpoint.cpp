@@ -0,0 +1,221 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//Checkpoint.cpp
+//
+//Class file for writing and reading simulator state checkpoints
+//
+
+#include "Checkpoint.h"
+#include "IniReader.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+CheckpointWriter::CheckpointWriter(const string &filename_) :
+	filename(filename_),
+	out(filename_.c_str(), ios::binary | ios::trunc)
+{
+	if (!out.is_open())
+	{
+		ERROR("Could not open checkpoint '"<<filename<<"' for writing");
+		exit(-1);
+	}
+	uint32_t magic = MAGIC, version = VERSION;
+	write(magic);
+	write(version);
+	write(IniReader::ConfigFingerprint());
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	close();
+}
+
+void CheckpointWriter::close()
+{
+	if (out.is_open())
+	{
+		out.close();
+		if (out.fail())
+		{
+			ERROR("Error writing checkpoint '"<<filename<<"'");
+			exit(-1);
+		}
+	}
+}
+
+void CheckpointWriter::writeSection(uint32_t tag)
+{
+	write(tag);
+}
+
+void CheckpointWriter::writePacket(const BusPacket *packet)
+{
+	write<bool>(packet != NULL);
+	if (packet)
+	{
+		write(packet->busPacketType);
+		write(packet->column);
+		write(packet->row);
+		write(packet->bank);
+		write(packet->rank);
+		write(packet->physicalAddress);
+		write(packet->timeEnqueued);
+		write(packet->timeActivated);
+		write(packet->timeIssued);
+		write(packet->refreshEnqueued);
+		write(packet->refreshActivated);
+		write(packet->refreshIssued);
+	}
+}
+
+void CheckpointWriter::writeTransaction(const Transaction *trans)
+{
+	write<bool>(trans != NULL);
+	if (trans)
+	{
+		write(trans->transactionType);
+		write(trans->address);
+		write(trans->timeCreated);
+		write(trans->timeAdded);
+		write(trans->timeScheduled);
+		write(trans->timeActivated);
+		write(trans->timeIssued);
+		write(trans->refreshBeforeActivate);
+		write(trans->refreshBeforeIssue);
+		write(trans->timeReturned);
+		write(trans->sourceId);
+	}
+}
+
+CheckpointReader::CheckpointReader(const string &filename_) :
+	filename(filename_),
+	in(filename_.c_str(), ios::binary)
+{
+	if (!in.is_open())
+	{
+		ERROR("Could not open checkpoint '"<<filename<<"'");
+		exit(-1);
+	}
+
+	uint32_t magic=0, version=0;
+	uint64_t fingerprint=0;
+	in.read((char *)&magic, sizeof(magic));
+	in.read((char *)&version, sizeof(version));
+	in.read((char *)&fingerprint, sizeof(fingerprint));
+	if (!in || magic != CheckpointWriter::MAGIC)
+	{
+		ERROR("'"<<filename<<"' is not a checkpoint");
+		exit(-1);
+	}
+	if (version != CheckpointWriter::VERSION)
+	{
+		ERROR("Checkpoint '"<<filename<<"' is version "<<version<<", expected "<<CheckpointWriter::VERSION);
+		exit(-1);
+	}
+	if (fingerprint != IniReader::ConfigFingerprint())
+	{
+		ERROR("Checkpoint '"<<filename<<"' was saved with a different configuration; use the same ini files, overrides and memory size");
+		exit(-1);
+	}
+}
+
+void CheckpointReader::check()
+{
+	if (!in)
+	{
+		ERROR("Checkpoint '"<<filename<<"' is truncated");
+		exit(-1);
+	}
+}
+
+void CheckpointReader::readSection(uint32_t tag)
+{
+	uint32_t found;
+	read(found);
+	if (found != tag)
+	{
+		ERROR("Checkpoint '"<<filename<<"' is corrupt (expected section "<<hex<<tag<<", found "<<found<<dec<<")");
+		exit(-1);
+	}
+}
+
+BusPacket *CheckpointReader::readPacket(ostream &dramsim_log)
+{
+	bool present;
+	read(present);
+	if (!present)
+	{
+		return NULL;
+	}
+	BusPacketType type;
+	unsigned column, row, bank, rank;
+	uint64_t physicalAddress;
+	read(type);
+	read(column);
+	read(row);
+	read(bank);
+	read(rank);
+	read(physicalAddress);
+	BusPacket *packet = new BusPacket(type, physicalAddress, column, row, rank, bank, NULL, dramsim_log);
+	read(packet->timeEnqueued);
+	read(packet->timeActivated);
+	read(packet->timeIssued);
+	read(packet->refreshEnqueued);
+	read(packet->refreshActivated);
+	read(packet->refreshIssued);
+	return packet;
+}
+
+Transaction *CheckpointReader::readTransaction()
+{
+	bool present;
+	read(present);
+	if (!present)
+	{
+		return NULL;
+	}
+	TransactionType type;
+	uint64_t address;
+	read(type);
+	read(address);
+	Transaction *trans = new Transaction(type, address, NULL);
+	read(trans->timeCreated);
+	read(trans->timeAdded);
+	read(trans->timeScheduled);
+	read(trans->timeActivated);
+	read(trans->timeIssued);
+	read(trans->refreshBeforeActivate);
+	read(trans->refreshBeforeIssue);
+	read(trans->timeReturned);
+	read(trans->sourceId);
+	return trans;
+}
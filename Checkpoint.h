@@ -0,0 +1,152 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+//Checkpoint.h
+//
+//Header file for writing and reading simulator state checkpoints
+//
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SystemConfiguration.h"
+#include "BusPacket.h"
+#include "Transaction.h"
+
+using std::string;
+using std::vector;
+
+namespace DRAMSim
+{
+// tags written at the start of each object's state
+enum CheckpointSection
+{
+	CHECKPOINT_MULTI_CHANNEL = 0x4D434D53, // "MCMS"
+	CHECKPOINT_CHANNEL = 0x4D454D53,       // "MEMS"
+	CHECKPOINT_CONTROLLER = 0x4D435452,    // "MCTR"
+	CHECKPOINT_COMMAND_QUEUE = 0x434D4451, // "CMDQ"
+	CHECKPOINT_RANK = 0x52414E4B,          // "RANK"
+	CHECKPOINT_BANK_STATE = 0x424E4B53,    // "BNKS"
+	CHECKPOINT_TRACE_DRIVER = 0x54445256,  // "TDRV"
+	CHECKPOINT_RECEIVER = 0x52435652,      // "RCVR"
+	CHECKPOINT_END = 0x454E4421            // "END!"
+};
+
+/*
+ * Checkpoint file format: a header
+ *
+ *   uint32_t magic, uint32_t version, uint64_t configuration fingerprint
+ *
+ * followed by the state of each object in the order it was saved. Every
+ * object starts its state with a section tag so that a reader that gets out
+ * of step with the writer stops right away instead of restoring garbage.
+ *
+ * Values are written in the host's native layout, so a checkpoint can only
+ * be restored by the same build on the same kind of machine, with the same
+ * ini files and overrides (checked through the fingerprint). The contents
+ * of the banks are not saved; the simulator is normally built with
+ * NO_STORAGE and then there is nothing to save.
+ */
+class CheckpointWriter
+{
+public:
+	static const uint32_t MAGIC = 0x4B435344; // "DSCK"
+	static const uint32_t VERSION = 7;
+
+	CheckpointWriter(const string &filename);
+	~CheckpointWriter();
+
+	// only for plain values (integers, enums, doubles)
+	template <typename T>
+	void write(const T &value)
+	{
+		out.write((const char *)&value, sizeof(T));
+	}
+	template <typename T>
+	void writeVector(const vector<T> &values)
+	{
+		write<uint64_t>(values.size());
+		for (size_t i=0; i<values.size(); i++)
+		{
+			write<T>(values[i]);
+		}
+	}
+	void writeSection(uint32_t tag);
+	void writePacket(const BusPacket *packet);
+	void writeTransaction(const Transaction *trans);
+	void close();
+
+	const string filename;
+
+private:
+	std::ofstream out;
+};
+
+class CheckpointReader
+{
+public:
+	CheckpointReader(const string &filename);
+
+	template <typename T>
+	void read(T &value)
+	{
+		in.read((char *)&value, sizeof(T));
+		check();
+	}
+	template <typename T>
+	void readVector(vector<T> &values)
+	{
+		uint64_t size;
+		read(size);
+		values.resize(size);
+		for (size_t i=0; i<size; i++)
+		{
+			T value;
+			read(value);
+			values[i] = value;
+		}
+	}
+	void readSection(uint32_t tag);
+	BusPacket *readPacket(ostream &dramsim_log);
+	Transaction *readTransaction();
+
+	const string filename;
+
+private:
+	void check();
+
+	std::ifstream in;
+};
+}
+
+#endif
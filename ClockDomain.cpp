@@ -8,17 +8,17 @@ namespace ClockDomain
 {
 	// "Default" crosser with a 1:1 ratio
 	ClockDomainCrosser::ClockDomainCrosser(ClockUpdateCB *_callback)
-		: callback(_callback), clock1(1UL), clock2(1UL), counter1(0UL), counter2(0UL)
+		: callback(_callback), clock1(1UL), clock2(1UL), counter1(0UL), counter2(0UL), ticks(0UL)
 	{
 	}
 	ClockDomainCrosser::ClockDomainCrosser(uint64_t _clock1, uint64_t _clock2, ClockUpdateCB *_callback) 
-		: callback(_callback), clock1(_clock1), clock2(_clock2), counter1(0), counter2(0)
+		: callback(_callback), clock1(_clock1), clock2(_clock2), counter1(0), counter2(0), ticks(0)
 	{
 		//cout << "CTOR: callback address: " << (uint64_t)(this->callback) << "\t ratio="<<clock1<<"/"<<clock2<< endl;
 	}
 
 	ClockDomainCrosser::ClockDomainCrosser(double ratio, ClockUpdateCB *_callback)
-		: callback(_callback), counter1(0), counter2(0)
+		: callback(_callback), counter1(0), counter2(0), ticks(0)
 	{
 		// Compute numerator and denominator for ratio, then pass that to other constructor.
 		double x = ratio;
@@ -58,6 +58,8 @@ namespace ClockDomain
 
 	void ClockDomainCrosser::update()
 	{
+		ticks++;
+
 		//short circuit case for 1:1 ratios
 		if (clock1 == clock2 && callback)
 		{
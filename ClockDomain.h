@@ -1,3 +1,6 @@
+#ifndef CLOCKDOMAIN_H
+#define CLOCKDOMAIN_H
+
 #include <iostream>
 
 #include <cmath>
@@ -44,6 +47,8 @@ namespace ClockDomain
 		ClockUpdateCB *callback;
 		uint64_t clock1, clock2;
 		uint64_t counter1, counter2;
+		// number of update() calls so far, i.e. cycles of the calling (CPU) clock
+		uint64_t ticks;
 		ClockDomainCrosser(ClockUpdateCB *_callback);
 		ClockDomainCrosser(uint64_t _clock1, uint64_t _clock2, ClockUpdateCB *_callback);
 		ClockDomainCrosser(double ratio, ClockUpdateCB *_callback);
@@ -59,3 +64,5 @@ namespace ClockDomain
 		int test();
 	};
 }
+
+#endif
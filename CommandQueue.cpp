@@ -42,6 +42,8 @@
 
 #include "CommandQueue.h"
 #include "MemoryController.h"
+#include "Checkpoint.h"
+#include "Profiler.h"
 #include <assert.h>
 
 using namespace DRAMSim;
@@ -78,6 +80,10 @@ CommandQueue::CommandQueue(vector< vector<BankState> > &states, ostream &dramsim
 
 	//vector of counters used to ensure rows don't stay open too long
 	rowAccessCounters = vector< vector<unsigned> >(NUM_RANKS, vector<unsigned>(NUM_BANKS,0));
+	forcedCloses = vector< vector<uint64_t> >(NUM_RANKS, vector<uint64_t>(NUM_BANKS,0));
+	lastActivate = vector<uint64_t>(NUM_RANKS,0);
+	activateHeldByFAW = false;
+	activateHeldByRRD = false;
 
 	//create queue based on the structure we want
 	BusPacket1D actualQueue;
@@ -163,6 +169,12 @@ void CommandQueue::enqueue(BusPacket *newBusPacket)
 //command scheduling policy
 bool CommandQueue::pop(BusPacket **busPacket)
 {
+	PROFILE_SCOPE(PROFILE_COMMAND_QUEUE_POP);
+
+	//set again by isIssuable() for this cycle's activates
+	activateHeldByFAW = false;
+	activateHeldByRRD = false;
+
 	//this can be done here because pop() is called every clock cycle by the parent MemoryController
 	//	figures out the sliding window requirement for tFAW
 	//
@@ -510,11 +522,15 @@ bool CommandQueue::pop(BusPacket **busPacket)
 						}
 
 						//if nothing found going to that bank and row or too many accesses have happend, close it
-						if (!found || rowAccessCounters[nextRankPRE][nextBankPRE]==TOTAL_ROW_ACCESSES)
+						if (!found || rowAccessCounters[nextRankPRE][nextBankPRE]>=TOTAL_ROW_ACCESSES)
 						{
 							if (currentClockCycle >= bankStates[nextRankPRE][nextBankPRE].nextPrecharge)
 							{
 								sendingPRE = true;
+								if (found)
+								{
+									forcedCloses[nextRankPRE][nextBankPRE]++;
+								}
 								rowAccessCounters[nextRankPRE][nextBankPRE] = 0;
 								*busPacket = new BusPacket(PRECHARGE, 0, 0, 0, nextRankPRE, nextBankPRE, 0, dramsim_log);
 								break;
@@ -549,6 +565,7 @@ bool CommandQueue::pop(BusPacket **busPacket)
 	if ((*busPacket)->busPacketType==ACTIVATE)
 	{
 		tFAWCountdown[(*busPacket)->rank].push_back(tFAW);
+		lastActivate[(*busPacket)->rank] = currentClockCycle;
 	}
 
 	return true;
@@ -558,7 +575,8 @@ bool CommandQueue::pop(BusPacket **busPacket)
 bool CommandQueue::hasRoomFor(unsigned numberToEnqueue, unsigned rank, unsigned bank)
 {
 	vector<BusPacket *> &queue = getCommandQueue(rank, bank); 
-	return (CMD_QUEUE_DEPTH - queue.size() >= numberToEnqueue);
+	// written so that it can't wrap around if CMD_QUEUE_DEPTH was lowered mid-run
+	return (queue.size() + numberToEnqueue <= CMD_QUEUE_DEPTH);
 }
 
 //prints the contents of the command queue
@@ -639,6 +657,20 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 		}
 		else
 		{
+			//note when only the four activate window or the activate to activate
+			//	delay of another bank holds it back (the latter set nextActivate last)
+			if (bankStates[busPacket->rank][busPacket->bank].currentBankState == Idle ||
+			        bankStates[busPacket->rank][busPacket->bank].currentBankState == Refreshing)
+			{
+				if (currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextActivate)
+				{
+					activateHeldByFAW = true;
+				}
+				else if (bankStates[busPacket->rank][busPacket->bank].nextActivate == lastActivate[busPacket->rank] + tRRD)
+				{
+					activateHeldByRRD = true;
+				}
+			}
 			return false;
 		}
 		break;
@@ -690,7 +722,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket)
 }
 
 //figures out if a rank's queue is empty
-bool CommandQueue::isEmpty(unsigned rank)
+bool CommandQueue::isEmpty(unsigned rank) const
 {
 	if (queuingStructure == PerRank)
 	{
@@ -711,6 +743,20 @@ bool CommandQueue::isEmpty(unsigned rank)
 	}
 }
 
+//number of commands waiting in all the queues
+size_t CommandQueue::size() const
+{
+	size_t total = 0;
+	for (size_t r=0;r<queues.size();r++)
+	{
+		for (size_t b=0;b<queues[r].size();b++)
+		{
+			total += queues[r][b].size();
+		}
+	}
+	return total;
+}
+
 //tells the command queue that a particular rank is in need of a refresh
 void CommandQueue::needRefresh(unsigned rank)
 {
@@ -718,6 +764,28 @@ void CommandQueue::needRefresh(unsigned rank)
 	refreshRank = rank;
 }
 
+//true while nothing but the refresh (and what closes the banks for it) may go to this rank
+bool CommandQueue::isWaitingForRefresh(unsigned rank) const
+{
+	return refreshWaiting && refreshRank == rank;
+}
+
+//the read or write that was enqueued with this activate, still waiting for it (NULL if there is none)
+BusPacket *CommandQueue::findColumnCommand(const BusPacket *activate)
+{
+	vector<BusPacket *> &queue = getCommandQueue(activate->rank, activate->bank);
+	for (size_t i=0;i<queue.size();i++)
+	{
+		BusPacket *packet = queue[i];
+		if (packet->busPacketType != ACTIVATE && packet->physicalAddress == activate->physicalAddress &&
+				packet->timeActivated == packet->timeEnqueued)
+		{
+			return packet;
+		}
+	}
+	return NULL;
+}
+
 void CommandQueue::nextRankAndBank(unsigned &rank, unsigned &bank)
 {
 	if (schedulingPolicy == RankThenBankRoundRobin)
@@ -761,3 +829,72 @@ void CommandQueue::update()
 	//needed for SimulatorObject
 	//TODO: make CommandQueue not a SimulatorObject
 }
+
+//the bank states belong to the memory controller, which saves them itself
+void CommandQueue::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_COMMAND_QUEUE);
+	checkpoint.write(currentClockCycle);
+	for (size_t r=0; r<queues.size(); r++)
+	{
+		for (size_t b=0; b<queues[r].size(); b++)
+		{
+			checkpoint.write<uint64_t>(queues[r][b].size());
+			for (size_t i=0; i<queues[r][b].size(); i++)
+			{
+				checkpoint.writePacket(queues[r][b][i]);
+			}
+		}
+	}
+	checkpoint.write(nextBank);
+	checkpoint.write(nextRank);
+	checkpoint.write(nextBankPRE);
+	checkpoint.write(nextRankPRE);
+	checkpoint.write(refreshRank);
+	checkpoint.write(refreshWaiting);
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		checkpoint.writeVector(tFAWCountdown[r]);
+		checkpoint.writeVector(rowAccessCounters[r]);
+		checkpoint.writeVector(forcedCloses[r]);
+	}
+	checkpoint.writeVector(lastActivate);
+	checkpoint.write(sendAct);
+}
+
+void CommandQueue::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readSection(CHECKPOINT_COMMAND_QUEUE);
+	checkpoint.read(currentClockCycle);
+	for (size_t r=0; r<queues.size(); r++)
+	{
+		for (size_t b=0; b<queues[r].size(); b++)
+		{
+			for (size_t i=0; i<queues[r][b].size(); i++)
+			{
+				delete queues[r][b][i];
+			}
+			uint64_t size;
+			checkpoint.read(size);
+			queues[r][b].resize(size);
+			for (size_t i=0; i<size; i++)
+			{
+				queues[r][b][i] = checkpoint.readPacket(dramsim_log);
+			}
+		}
+	}
+	checkpoint.read(nextBank);
+	checkpoint.read(nextRank);
+	checkpoint.read(nextBankPRE);
+	checkpoint.read(nextRankPRE);
+	checkpoint.read(refreshRank);
+	checkpoint.read(refreshWaiting);
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		checkpoint.readVector(tFAWCountdown[r]);
+		checkpoint.readVector(rowAccessCounters[r]);
+		checkpoint.readVector(forcedCloses[r]);
+	}
+	checkpoint.readVector(lastActivate);
+	checkpoint.read(sendAct);
+}
@@ -51,6 +51,9 @@ using namespace std;
 
 namespace DRAMSim
 {
+class CheckpointWriter;
+class CheckpointReader;
+
 class CommandQueue : public SimulatorObject
 {
 	CommandQueue();
@@ -69,16 +72,28 @@ public:
 	bool pop(BusPacket **busPacket);
 	bool hasRoomFor(unsigned numberToEnqueue, unsigned rank, unsigned bank);
 	bool isIssuable(BusPacket *busPacket);
-	bool isEmpty(unsigned rank);
+	bool isEmpty(unsigned rank) const;
+	size_t size() const;
 	void needRefresh(unsigned rank);
+	bool isWaitingForRefresh(unsigned rank) const;
+	BusPacket *findColumnCommand(const BusPacket *activate);
 	void print();
 	void update(); //SimulatorObject requirement
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
 	vector<BusPacket *> &getCommandQueue(unsigned rank, unsigned bank);
 
 	//fields
 	
 	BusPacket3D queues; // 3D array of BusPacket pointers
 	vector< vector<BankState> > &bankStates;
+	// rows closed by TOTAL_ROW_ACCESSES while hits to them were still queued,
+	// since the memory controller last reported (and cleared) them
+	vector< vector<uint64_t> > forcedCloses;
+	// set during pop() when an activate could have gone out this cycle but for
+	// tFAW (four activates in the window) or tRRD (another bank's activate)
+	bool activateHeldByFAW;
+	bool activateHeldByRRD;
 private:
 	void nextRankAndBank(unsigned &rank, unsigned &bank);
 	//fields
@@ -93,6 +108,7 @@ private:
 
 	vector< vector<unsigned> > tFAWCountdown;
 	vector< vector<unsigned> > rowAccessCounters;
+	vector<uint64_t> lastActivate;
 
 	bool sendAct;
 };
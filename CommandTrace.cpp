@@ -0,0 +1,102 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//CommandTrace.cpp
+//
+//Writes the binary command trace of one channel
+//
+
+#include <iostream>
+#include <string.h>
+#include <sched.h>
+#include "CommandTrace.h"
+#include "PrintMacros.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+// 64k commands (1.25MB), a few hundred thousand cycles of a busy channel
+static const unsigned COMMAND_BUFFER_BITS = 16;
+static const unsigned COMMAND_WRITER_SLEEP_US = 200;
+// size of one record in the file (CommandRecord without its padding)
+static const size_t RECORD_BYTES = 20;
+
+CommandTrace::CommandTrace(const string &filename_, unsigned channel_) :
+	RingWriter<CommandRecord>(COMMAND_BUFFER_BITS, COMMAND_WRITER_SLEEP_US),
+	filename(filename_),
+	channel(channel_),
+	out(filename_.c_str(), ios::out | ios::binary),
+	stalls(0)
+{
+	if (!out)
+	{
+		ERROR("Cannot open '"<<filename<<"'");
+		exit(-1);
+	}
+	uint32_t header[3] = {MAGIC, VERSION, channel};
+	out.write((const char *)header, sizeof(header));
+	if (!start())
+	{
+		ERROR("Cannot start the command trace writer thread");
+		exit(-1);
+	}
+}
+
+CommandTrace::~CommandTrace()
+{
+	stop();
+	out.close();
+	if (stalls > 0)
+	{
+		cerr << "NOTE: the simulation waited " << stalls << " times for " << filename << " to be written" << endl;
+	}
+}
+
+void CommandTrace::waitForWriter()
+{
+	stalls++;
+	sched_yield();
+}
+
+void CommandTrace::write(CommandRecord &record)
+{
+	char bytes[RECORD_BYTES];
+	uint32_t row = record.row, column = record.column;
+	memcpy(bytes, &record.cycle, 8);
+	memcpy(bytes + 8, &row, 4);
+	memcpy(bytes + 12, &column, 4);
+	bytes[16] = record.channel;
+	bytes[17] = record.rank;
+	bytes[18] = record.bank;
+	bytes[19] = record.command;
+	out.write(bytes, RECORD_BYTES);
+}
+}
@@ -0,0 +1,116 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef COMMANDTRACE_H
+#define COMMANDTRACE_H
+
+//CommandTrace.h
+//
+//Header file for the binary trace of the commands a channel sends its ranks
+//
+
+#include <fstream>
+#include <string>
+#include "RingWriter.h"
+#include "BusPacket.h"
+
+using std::string;
+
+namespace DRAMSim
+{
+// one command as a rank received it
+struct CommandRecord
+{
+	uint64_t cycle;
+	unsigned row;
+	unsigned column;
+	unsigned char channel;
+	unsigned char rank;
+	unsigned char bank;
+	unsigned char command; // a BusPacketType
+};
+
+/*
+ * Binary counterpart of VERIFICATION_OUTPUT for one channel. File format
+ * (little endian): a header
+ *
+ *   uint32_t magic, uint32_t version, uint32_t channel
+ *
+ * followed by one 20 byte record per command
+ *
+ *   uint64_t cycle, uint32_t row, uint32_t column,
+ *   uint8_t channel, uint8_t rank, uint8_t bank, uint8_t BusPacketType
+ *
+ * cmdtrace2txt.py turns one or more of these back into the modelsim text.
+ * Records are written from a writer thread, as in Sampler, but a command
+ * trace that is missing commands is useless for validation so add() waits
+ * for the writer instead of dropping anything when the ring is full.
+ */
+class CommandTrace : private RingWriter<CommandRecord>
+{
+public:
+	static const uint32_t MAGIC = 0x54435344; // "DSCT"
+	static const uint32_t VERSION = 1;
+
+	CommandTrace(const string &filename, unsigned channel);
+	~CommandTrace();
+	void add(uint64_t cycle, const BusPacket *packet)
+	{
+		if (packet->busPacketType == DATA)
+		{
+			return;
+		}
+		CommandRecord record;
+		record.cycle = cycle;
+		record.row = packet->row;
+		record.column = packet->column;
+		record.channel = channel;
+		record.rank = packet->rank;
+		record.bank = packet->bank;
+		record.command = packet->busPacketType;
+		while (!push(record))
+		{
+			waitForWriter();
+		}
+	}
+
+	const string filename;
+
+private:
+	void write(CommandRecord &record);
+	void waitForWriter();
+
+	const unsigned channel;
+	std::ofstream out;
+	uint64_t stalls;
+};
+}
+
+#endif
@@ -46,6 +46,14 @@ namespace DRAMSim
 		public: 
 			bool addTransaction(bool isWrite, uint64_t addr);
 			void setCPUClockSpeed(uint64_t cpuClkFreqHz);
+			void startRecording(const string &filename);
+			void stopRecording();
+			void saveCheckpoint(const string &filename) const;
+			void restoreCheckpoint(const string &filename);
+			void useAnalyticalModel(const string &coefficientsFilename="");
+			void startCalibration();
+			bool finishCalibration(const string &coefficientsFilename);
+			void simulateOnlyChannel(unsigned channel);
 			void update();
 			void printStats(bool finalStats);
 			bool willAcceptTransaction(); 
@@ -37,6 +37,18 @@
 
 #include "IniReader.h"
 
+// a release build still reads the debug switches, into the variables below
+#ifdef DRAMSIM_RELEASE
+#undef VERIFICATION_OUTPUT
+#undef DEBUG_TRANS_Q
+#undef DEBUG_CMD_Q
+#undef DEBUG_ADDR_MAP
+#undef DEBUG_BANKSTATE
+#undef DEBUG_BUS
+#undef DEBUG_BANKS
+#undef DEBUG_POWER
+#endif
+
 using namespace std;
 
 // these are the values that are extern'd in SystemConfig.h so that they
@@ -96,6 +108,7 @@ unsigned CMD_QUEUE_DEPTH;
 
 //cycles within an epoch
 unsigned EPOCH_LENGTH;
+unsigned SAMPLE_INTERVAL;
 
 //row accesses allowed before closing (open page)
 unsigned TOTAL_ROW_ACCESSES;
@@ -118,8 +131,10 @@ bool DEBUG_BANKS;
 bool DEBUG_POWER;
 bool USE_LOW_POWER;
 bool VIS_FILE_OUTPUT;
+bool VIS_FILE_BINARY;
 
 bool VERIFICATION_OUTPUT;
+bool COMMAND_TRACE_OUTPUT;
 
 bool DEBUG_INI_READER=false;
 
@@ -183,6 +198,7 @@ static ConfigMap configMap[] =
 	DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
 
 	DEFINE_UINT_PARAM(EPOCH_LENGTH,SYS_PARAM),
+	DEFINE_UINT_PARAM(SAMPLE_INTERVAL,SYS_PARAM),
 	//Power
 	DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
 
@@ -204,11 +220,13 @@ static ConfigMap configMap[] =
 	DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
 	DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
 	DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
+	DEFINE_BOOL_PARAM(VIS_FILE_BINARY,SYS_PARAM),
 	DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
+	DEFINE_BOOL_PARAM(COMMAND_TRACE_OUTPUT,SYS_PARAM),
 	{"", NULL, UINT, SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
 };
 
-void IniReader::WriteParams(std::ofstream &visDataOut, paramType type)
+void IniReader::WriteParams(std::ostream &visDataOut, paramType type)
 {
 	for (size_t i=0; configMap[i].variablePtr != NULL; i++)
 	{
@@ -261,6 +279,68 @@ void IniReader::WriteValuesOut(std::ofstream &visDataOut)
 
 }
 
+/*
+ * Parameters that only steer decisions made from here on and so can be
+ * overridden in a simulation that is already running (see the sweep in
+ * TraceBasedSim). Anything that sizes a structure, changes the address
+ * mapping or the clock, or could strand state built up under the old value
+ * (e.g. rows left open when switching to close page, ranks left powered
+ * down when turning low power off) is not on the list.
+ */
+bool IniReader::IsRuntimeSafe(const string &key)
+{
+	static const char *runtimeSafeKeys[] =
+	{
+		"TRANS_QUEUE_DEPTH",
+		"CMD_QUEUE_DEPTH",
+		"SCHEDULING_POLICY",
+		"TOTAL_ROW_ACCESSES",
+		NULL
+	};
+	for (size_t i=0; runtimeSafeKeys[i] != NULL; i++)
+	{
+		if (key == runtimeSafeKeys[i])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Hash (FNV-1a) of every parameter that affects the simulated state, used to
+ * make sure a checkpoint is restored into the same configuration it was
+ * saved from. The debug and output switches are left out so that a restored
+ * run can turn them on or off.
+ */
+uint64_t IniReader::ConfigFingerprint()
+{
+	stringstream params;
+	WriteParams(params, SYS_PARAM);
+	WriteParams(params, DEV_PARAM);
+
+	uint64_t hash = 14695981039346656037ULL;
+	string line;
+	while (getline(params, line))
+	{
+		if (line.compare(0, 6, "DEBUG_") == 0 ||
+				line.compare(0, 16, "VIS_FILE_OUTPUT=") == 0 ||
+				line.compare(0, 16, "VIS_FILE_BINARY=") == 0 ||
+				line.compare(0, 16, "SAMPLE_INTERVAL=") == 0 ||
+				line.compare(0, 20, "VERIFICATION_OUTPUT=") == 0 ||
+				line.compare(0, 21, "COMMAND_TRACE_OUTPUT=") == 0)
+		{
+			continue;
+		}
+		for (size_t i=0; i<line.length(); i++)
+		{
+			hash = (hash ^ (unsigned char)line[i]) * 1099511628211ULL;
+		}
+		hash = (hash ^ '\n') * 1099511628211ULL;
+	}
+	return hash;
+}
+
 void IniReader::SetKey(string key, string valueString, bool isSystemParam, size_t lineNumber)
 {
 	size_t i;
@@ -454,6 +534,13 @@ bool IniReader::CheckIfAllSet()
 			{
 				//the string and bool values can be defaulted, but generally we need all the numeric values to be set to continue
 			case UINT:
+				//sampling is off unless asked for
+				if (configMap[i].iniKey == "SAMPLE_INTERVAL")
+				{
+					SAMPLE_INTERVAL = 0;
+					DEBUG("\tSetting Default: "<<configMap[i].iniKey<<"=0");
+					break;
+				}
 			case UINT64:
 			case FLOAT:
 				ERROR("Cannot continue without key '"<<configMap[i].iniKey<<"' set.");
@@ -473,6 +560,13 @@ bool IniReader::CheckIfAllSet()
 			}
 		}
 	}
+#ifdef DRAMSIM_RELEASE
+	if (VERIFICATION_OUTPUT || DEBUG_TRANS_Q || DEBUG_CMD_Q || DEBUG_ADDR_MAP || DEBUG_BANKSTATE ||
+			DEBUG_BUS || DEBUG_BANKS || DEBUG_POWER)
+	{
+		DEBUG("WARNING: the DEBUG_* and VERIFICATION_OUTPUT switches are compiled out of this release build; they have no effect");
+	}
+#endif
 	return true;
 }
 void IniReader::InitEnumsFromStrings()
@@ -74,9 +74,11 @@ public:
 	static void InitEnumsFromStrings();
 	static bool CheckIfAllSet();
 	static void WriteValuesOut(std::ofstream &visDataOut);
+	static uint64_t ConfigFingerprint();
+	static bool IsRuntimeSafe(const string &key);
 
 private:
-	static void WriteParams(std::ofstream &visDataOut, paramType t);
+	static void WriteParams(std::ostream &visDataOut, paramType t);
 	static void Trim(string &str);
 };
 }
@@ -0,0 +1,130 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//LatencyHistogram.cpp
+//
+//Class file for the log-linear latency histogram
+//
+
+#include <cmath>
+#include "LatencyHistogram.h"
+#include "Checkpoint.h"
+
+using namespace DRAMSim;
+
+LatencyHistogram::LatencyHistogram() :
+	counts(NUM_BUCKETS, 0),
+	total(0),
+	maxLatency(0)
+{}
+
+// latencies in [2^k, 2^(k+1)) for k >= SUB_BUCKET_BITS are cut into SUB_BUCKETS/2 buckets
+unsigned LatencyHistogram::bucketIndex(uint32_t latency)
+{
+	if (latency < SUB_BUCKETS)
+	{
+		return latency;
+	}
+	unsigned msb = 31 - __builtin_clz(latency);
+	unsigned shift = msb - (SUB_BUCKET_BITS - 1);
+	return SUB_BUCKETS + (msb - SUB_BUCKET_BITS) * (SUB_BUCKETS / 2) + ((latency >> shift) - SUB_BUCKETS / 2);
+}
+
+uint32_t LatencyHistogram::bucketHighest(unsigned index)
+{
+	if (index < SUB_BUCKETS)
+	{
+		return index;
+	}
+	unsigned octave = (index - SUB_BUCKETS) / (SUB_BUCKETS / 2);
+	unsigned subBucket = (index - SUB_BUCKETS) % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+	unsigned shift = octave + 1;
+	return (uint32_t)((((uint64_t)subBucket + 1) << shift) - 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+	for (size_t i=0; i<NUM_BUCKETS; i++)
+	{
+		counts[i] += other.counts[i];
+	}
+	total += other.total;
+	if (other.maxLatency > maxLatency)
+	{
+		maxLatency = other.maxLatency;
+	}
+}
+
+void LatencyHistogram::reset()
+{
+	counts.assign(NUM_BUCKETS, 0);
+	total = 0;
+	maxLatency = 0;
+}
+
+// the smallest latency that at least percent % of the latencies are at or below (0 when empty)
+uint32_t LatencyHistogram::percentile(double percent) const
+{
+	if (total == 0)
+	{
+		return 0;
+	}
+	// (the epsilon keeps e.g. 99.9% of 100000 from rounding up to 99901)
+	uint64_t rank = (uint64_t)ceil(percent / 100.0 * total - 1e-6);
+	if (rank < 1)
+	{
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (size_t i=0; i<NUM_BUCKETS; i++)
+	{
+		seen += counts[i];
+		if (seen >= rank)
+		{
+			uint32_t highest = bucketHighest(i);
+			return (highest < maxLatency) ? highest : maxLatency;
+		}
+	}
+	return maxLatency;
+}
+
+void LatencyHistogram::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeVector(counts);
+	checkpoint.write(total);
+	checkpoint.write(maxLatency);
+}
+
+void LatencyHistogram::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readVector(counts);
+	checkpoint.read(total);
+	checkpoint.read(maxLatency);
+}
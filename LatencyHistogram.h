@@ -0,0 +1,100 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+//LatencyHistogram.h
+//
+//Header file for the log-linear latency histogram used for percentiles
+//
+
+#include <stdint.h>
+#include <vector>
+
+using std::vector;
+
+namespace DRAMSim
+{
+class CheckpointWriter;
+class CheckpointReader;
+
+/*
+ * LatencyHistogram: an HDR-style log-linear histogram. Latencies below
+ * SUB_BUCKETS cycles get a bucket each; above that every power of two is
+ * split into SUB_BUCKETS/2 equal buckets, so a bucket is never wider than
+ * 1/64 of the values in it. All of it lives in one flat array of
+ * NUM_BUCKETS counts, so add() is an index computation and an increment,
+ * and a percentile is one pass over the array.
+ *
+ * percentile() returns the highest latency of the bucket the percentile
+ * falls in (but no more than the largest latency added), i.e. it errs on
+ * the side of reporting a latency too high rather than too low.
+ */
+class LatencyHistogram
+{
+public:
+	static const unsigned SUB_BUCKET_BITS = 7;
+	static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	// enough for any 32 bit latency
+	static const unsigned NUM_BUCKETS = SUB_BUCKETS + (32 - SUB_BUCKET_BITS) * (SUB_BUCKETS / 2);
+
+	LatencyHistogram();
+
+	void add(uint32_t latency)
+	{
+		counts[bucketIndex(latency)]++;
+		total++;
+		if (latency > maxLatency)
+		{
+			maxLatency = latency;
+		}
+	}
+	void merge(const LatencyHistogram &other);
+	void reset();
+	uint64_t count() const
+	{
+		return total;
+	}
+	uint32_t percentile(double percent) const;
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
+
+	static unsigned bucketIndex(uint32_t latency);
+	static uint32_t bucketHighest(unsigned index);
+
+private:
+	vector<uint64_t> counts;
+	uint64_t total;
+	uint32_t maxLatency;
+};
+}
+
+#endif
@@ -38,6 +38,11 @@
 #include "MemoryController.h"
 #include "MemorySystem.h"
 #include "AddressMapping.h"
+#include "Checkpoint.h"
+#include "Profiler.h"
+#include <limits>
+#include <sstream>
+#include <algorithm>
 
 #define SEQUENTIAL(rank,bank) (rank*NUM_BANKS)+bank
 
@@ -90,6 +95,23 @@ MemoryController::MemoryController(MemorySystem *parent, CSVWriter &csvOut_, ost
 	totalWritesPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
 	totalReadsPerRank = vector<uint64_t>(NUM_RANKS,0);
 	totalWritesPerRank = vector<uint64_t>(NUM_RANKS,0);
+	rowHitsPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
+	rowMissesPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
+	rowConflictsPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
+	activatesPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
+	prechargesPerBank = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
+	rowClosedTime = vector<uint64_t>(NUM_RANKS*NUM_BANKS,0);
+	dataBusBusyCycles = 0;
+	turnaroundCycles = 0;
+	rankSwitchCycles = 0;
+	cmdBusBusyCycles = 0;
+	fawBlockedCycles = 0;
+	rrdBlockedCycles = 0;
+	dataBusFreeTime = 0;
+	lastBurstRank = 0;
+	lastBurstWasRead = true;
+	sampleTransactions = 0;
+	sampleCycle = 0;
 
 	writeDataCountdown.reserve(NUM_RANKS);
 	writeDataToSend.reserve(NUM_RANKS);
@@ -102,6 +124,10 @@ MemoryController::MemoryController(MemorySystem *parent, CSVWriter &csvOut_, ost
 	refreshEnergy = vector <uint64_t> (NUM_RANKS,0);
 
 	totalEpochLatency = vector<uint64_t> (NUM_RANKS*NUM_BANKS,0);
+	epochRankLatencies = vector<LatencyHistogram> (NUM_RANKS);
+	refreshBlockedCycles = vector<uint64_t> (NUM_RANKS,0);
+	epochStageLatency = vector<uint64_t> (NUM_LATENCY_STAGES,0);
+	runStageLatency = vector<uint64_t> (NUM_LATENCY_STAGES,0);
 
 	//staggers when each rank is due for a refresh
 	for (size_t i=0;i<NUM_RANKS;i++)
@@ -126,8 +152,13 @@ void MemoryController::receiveFromBus(BusPacket *bpacket)
 		bpacket->print();
 	}
 
-	//add to return read data queue
-	returnTransaction.push_back(new Transaction(RETURN_DATA, bpacket->physicalAddress, bpacket->data));
+	//add to return read data queue, with the bus packet's part of the latency breakdown
+	Transaction *returned = new Transaction(RETURN_DATA, bpacket->physicalAddress, bpacket->data);
+	returned->timeActivated = bpacket->timeActivated;
+	returned->timeIssued = bpacket->timeIssued;
+	returned->refreshBeforeActivate = bpacket->refreshActivated - bpacket->refreshEnqueued;
+	returned->refreshBeforeIssue = bpacket->refreshIssued - bpacket->refreshActivated;
+	returnTransaction.push_back(returned);
 	totalReadsPerBank[SEQUENTIAL(bpacket->rank,bpacket->bank)]++;
 
 	// this delete statement saves a mindboggling amount of memory
@@ -156,34 +187,37 @@ void MemoryController::update()
 	//PRINT(" ------------------------- [" << currentClockCycle << "] -------------------------");
 
 	//update bank states
-	for (size_t i=0;i<NUM_RANKS;i++)
 	{
-		for (size_t j=0;j<NUM_BANKS;j++)
+		PROFILE_SCOPE(PROFILE_BANK_STATES);
+		for (size_t i=0;i<NUM_RANKS;i++)
 		{
-			if (bankStates[i][j].stateChangeCountdown>0)
+			for (size_t j=0;j<NUM_BANKS;j++)
 			{
-				//decrement counters
-				bankStates[i][j].stateChangeCountdown--;
-
-				//if counter has reached 0, change state
-				if (bankStates[i][j].stateChangeCountdown == 0)
+				if (bankStates[i][j].stateChangeCountdown>0)
 				{
-					switch (bankStates[i][j].lastCommand)
+					//decrement counters
+					bankStates[i][j].stateChangeCountdown--;
+
+					//if counter has reached 0, change state
+					if (bankStates[i][j].stateChangeCountdown == 0)
 					{
-						//only these commands have an implicit state change
-					case WRITE_P:
-					case READ_P:
-						bankStates[i][j].currentBankState = Precharging;
-						bankStates[i][j].lastCommand = PRECHARGE;
-						bankStates[i][j].stateChangeCountdown = tRP;
-						break;
-
-					case REFRESH:
-					case PRECHARGE:
-						bankStates[i][j].currentBankState = Idle;
-						break;
-					default:
-						break;
+						switch (bankStates[i][j].lastCommand)
+						{
+							//only these commands have an implicit state change
+						case WRITE_P:
+						case READ_P:
+							bankStates[i][j].currentBankState = Precharging;
+							bankStates[i][j].lastCommand = PRECHARGE;
+							bankStates[i][j].stateChangeCountdown = tRP;
+							break;
+
+						case REFRESH:
+						case PRECHARGE:
+							bankStates[i][j].currentBankState = Idle;
+							break;
+						default:
+							break;
+						}
 					}
 				}
 			}
@@ -261,21 +295,24 @@ void MemoryController::update()
 
 	//if its time for a refresh issue a refresh
 	// else pop from command queue if it's not empty
-	if (refreshCountdown[refreshRank]==0)
 	{
-		commandQueue.needRefresh(refreshRank);
-		(*ranks)[refreshRank]->refreshWaiting = true;
-		refreshCountdown[refreshRank] =	 REFRESH_PERIOD/tCK;
-		refreshRank++;
-		if (refreshRank == NUM_RANKS)
+		PROFILE_SCOPE(PROFILE_REFRESH);
+		if (refreshCountdown[refreshRank]==0)
 		{
-			refreshRank = 0;
+			commandQueue.needRefresh(refreshRank);
+			(*ranks)[refreshRank]->refreshWaiting = true;
+			refreshCountdown[refreshRank] =	 REFRESH_PERIOD/tCK;
+			refreshRank++;
+			if (refreshRank == NUM_RANKS)
+			{
+				refreshRank = 0;
+			}
+		}
+		//if a rank is powered down, make sure we power it up in time for a refresh
+		else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= tXP)
+		{
+			(*ranks)[refreshRank]->refreshWaiting = true;
 		}
-	}
-	//if a rank is powered down, make sure we power it up in time for a refresh
-	else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= tXP)
-	{
-		(*ranks)[refreshRank]->refreshWaiting = true;
 	}
 
 	//pass a pointer to a poppedBusPacket
@@ -283,6 +320,51 @@ void MemoryController::update()
 	//function returns true if there is something valid in poppedBusPacket
 	if (commandQueue.pop(&poppedBusPacket))
 	{
+		//stamp the latency breakdown: an activate on the column command that was enqueued
+		//	with it, a column command on itself
+		//	and count the row buffer outcome: a column command that didn't need its activate
+		//	is a hit, one whose activate had to wait for another row to close is a conflict
+		unsigned poppedBank = SEQUENTIAL(poppedBusPacket->rank,poppedBusPacket->bank);
+		if (poppedBusPacket->busPacketType == ACTIVATE)
+		{
+			activatesPerBank[poppedBank]++;
+			BusPacket *columnCommand = commandQueue.findColumnCommand(poppedBusPacket);
+			if (columnCommand != NULL)
+			{
+				if (rowClosedTime[poppedBank] > columnCommand->timeEnqueued)
+				{
+					rowConflictsPerBank[poppedBank]++;
+				}
+				else
+				{
+					rowMissesPerBank[poppedBank]++;
+				}
+				columnCommand->timeActivated = currentClockCycle;
+				columnCommand->refreshActivated = refreshBlockedCycles[poppedBusPacket->rank];
+			}
+		}
+		else if (poppedBusPacket->busPacketType == PRECHARGE)
+		{
+			prechargesPerBank[poppedBank]++;
+			rowClosedTime[poppedBank] = currentClockCycle;
+		}
+		else if (poppedBusPacket->busPacketType != REFRESH)
+		{
+			if (poppedBusPacket->timeActivated == poppedBusPacket->timeEnqueued)
+			{
+				rowHitsPerBank[poppedBank]++;
+			}
+			if (poppedBusPacket->busPacketType == READ_P || poppedBusPacket->busPacketType == WRITE_P)
+			{
+				prechargesPerBank[poppedBank]++;
+				rowClosedTime[poppedBank] = currentClockCycle;
+			}
+			poppedBusPacket->timeIssued = currentClockCycle;
+			poppedBusPacket->refreshIssued = refreshBlockedCycles[poppedBusPacket->rank];
+			addDataBurst(poppedBusPacket);
+		}
+		cmdBusBusyCycles += tCMD;
+
 		if (poppedBusPacket->busPacketType == WRITE || poppedBusPacket->busPacketType == WRITE_P)
 		{
 
@@ -488,172 +570,187 @@ void MemoryController::update()
 		cmdCyclesLeft = tCMD;
 
 	}
+	else if (commandQueue.activateHeldByFAW)
+	{
+		fawBlockedCycles++;
+	}
+	else if (commandQueue.activateHeldByRRD)
+	{
+		rrdBlockedCycles++;
+	}
 
-	for (size_t i=0;i<transactionQueue.size();i++)
 	{
-		//pop off top transaction from queue
-		//
-		//	assuming simple scheduling at the moment
-		//	will eventually add policies here
-		Transaction *transaction = transactionQueue[i];
+		PROFILE_SCOPE(PROFILE_TRANSACTION_DECODE);
+		for (size_t i=0;i<transactionQueue.size();i++)
+		{
+			//pop off top transaction from queue
+			//
+			//	assuming simple scheduling at the moment
+			//	will eventually add policies here
+			Transaction *transaction = transactionQueue[i];
 
-		//map address to rank,bank,row,col
-		unsigned newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn;
+			//map address to rank,bank,row,col
+			unsigned newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn;
 
-		// pass these in as references so they get set by the addressMapping function
-		addressMapping(transaction->address, newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn);
+			// pass these in as references so they get set by the addressMapping function
+			addressMapping(transaction->address, newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow, newTransactionColumn);
 
-		//if we have room, break up the transaction into the appropriate commands
-		//and add them to the command queue
-		if (commandQueue.hasRoomFor(2, newTransactionRank, newTransactionBank))
-		{
-			if (DEBUG_ADDR_MAP) 
+			//if we have room, break up the transaction into the appropriate commands
+			//and add them to the command queue
+			if (commandQueue.hasRoomFor(2, newTransactionRank, newTransactionBank))
 			{
-				PRINTN("== New Transaction - Mapping Address [0x" << hex << transaction->address << dec << "]");
-				if (transaction->transactionType == DATA_READ) 
-				{
-					PRINT(" (Read)");
-				}
-				else
+				if (DEBUG_ADDR_MAP) 
 				{
-					PRINT(" (Write)");
+					PRINTN("== New Transaction - Mapping Address [0x" << hex << transaction->address << dec << "]");
+					if (transaction->transactionType == DATA_READ) 
+					{
+						PRINT(" (Read)");
+					}
+					else
+					{
+						PRINT(" (Write)");
+					}
+					PRINT("  Rank : " << newTransactionRank);
+					PRINT("  Bank : " << newTransactionBank);
+					PRINT("  Row  : " << newTransactionRow);
+					PRINT("  Col  : " << newTransactionColumn);
 				}
-				PRINT("  Rank : " << newTransactionRank);
-				PRINT("  Bank : " << newTransactionBank);
-				PRINT("  Row  : " << newTransactionRow);
-				PRINT("  Col  : " << newTransactionColumn);
-			}
-
-
 
-			//now that we know there is room in the command queue, we can remove from the transaction queue
-			transactionQueue.erase(transactionQueue.begin()+i);
 
-			//create activate command to the row we just translated
-			BusPacket *ACTcommand = new BusPacket(ACTIVATE, transaction->address,
-					newTransactionColumn, newTransactionRow, newTransactionRank,
-					newTransactionBank, 0, dramsim_log);
 
-			//create read or write command and enqueue it
-			BusPacketType bpType = transaction->getBusPacketType();
-			BusPacket *command = new BusPacket(bpType, transaction->address,
-					newTransactionColumn, newTransactionRow, newTransactionRank,
-					newTransactionBank, transaction->data, dramsim_log);
+				//now that we know there is room in the command queue, we can remove from the transaction queue
+				transactionQueue.erase(transactionQueue.begin()+i);
 
+				//create activate command to the row we just translated
+				BusPacket *ACTcommand = new BusPacket(ACTIVATE, transaction->address,
+						newTransactionColumn, newTransactionRow, newTransactionRank,
+						newTransactionBank, 0, dramsim_log);
 
+				//create read or write command and enqueue it
+				BusPacketType bpType = transaction->getBusPacketType();
+				BusPacket *command = new BusPacket(bpType, transaction->address,
+						newTransactionColumn, newTransactionRow, newTransactionRank,
+						newTransactionBank, transaction->data, dramsim_log);
+				transaction->timeScheduled = currentClockCycle;
+				command->timeEnqueued = command->timeActivated = currentClockCycle;
+				command->refreshEnqueued = command->refreshActivated = refreshBlockedCycles[newTransactionRank];
 
-			commandQueue.enqueue(ACTcommand);
-			commandQueue.enqueue(command);
+				commandQueue.enqueue(ACTcommand);
+				commandQueue.enqueue(command);
 
-			// If we have a read, save the transaction so when the data comes back
-			// in a bus packet, we can staple it back into a transaction and return it
-			if (transaction->transactionType == DATA_READ)
-			{
-				pendingReadTransactions.push_back(transaction);
+				// If we have a read, save the transaction so when the data comes back
+				// in a bus packet, we can staple it back into a transaction and return it
+				if (transaction->transactionType == DATA_READ)
+				{
+					pendingReadTransactions.push_back(transaction);
+				}
+				else
+				{
+					// just delete the transaction now that it's a buspacket
+					delete transaction; 
+				}
+				/* only allow one transaction to be scheduled per cycle -- this should
+				 * be a reasonable assumption considering how much logic would be
+				 * required to schedule multiple entries per cycle (parallel data
+				 * lines, switching logic, decision logic)
+				 */
+				break;
 			}
-			else
+			else // no room, do nothing this cycle
 			{
-				// just delete the transaction now that it's a buspacket
-				delete transaction; 
+				//PRINT( "== Warning - No room in command queue" << endl;
 			}
-			/* only allow one transaction to be scheduled per cycle -- this should
-			 * be a reasonable assumption considering how much logic would be
-			 * required to schedule multiple entries per cycle (parallel data
-			 * lines, switching logic, decision logic)
-			 */
-			break;
-		}
-		else // no room, do nothing this cycle
-		{
-			//PRINT( "== Warning - No room in command queue" << endl;
 		}
 	}
 
 
 	//calculate power
 	//  this is done on a per-rank basis, since power characterization is done per device (not per bank)
-	for (size_t i=0;i<NUM_RANKS;i++)
 	{
-		if (USE_LOW_POWER)
+		PROFILE_SCOPE(PROFILE_POWER);
+		for (size_t i=0;i<NUM_RANKS;i++)
 		{
-			//if there are no commands in the queue and that particular rank is not waiting for a refresh...
-			if (commandQueue.isEmpty(i) && !(*ranks)[i]->refreshWaiting)
+			if (USE_LOW_POWER)
 			{
-				//check to make sure all banks are idle
-				bool allIdle = true;
-				for (size_t j=0;j<NUM_BANKS;j++)
+				//if there are no commands in the queue and that particular rank is not waiting for a refresh...
+				if (commandQueue.isEmpty(i) && !(*ranks)[i]->refreshWaiting)
 				{
-					if (bankStates[i][j].currentBankState != Idle)
+					//check to make sure all banks are idle
+					bool allIdle = true;
+					for (size_t j=0;j<NUM_BANKS;j++)
 					{
-						allIdle = false;
-						break;
+						if (bankStates[i][j].currentBankState != Idle)
+						{
+							allIdle = false;
+							break;
+						}
 					}
-				}
 
-				//if they ARE all idle, put in power down mode and set appropriate fields
-				if (allIdle)
+					//if they ARE all idle, put in power down mode and set appropriate fields
+					if (allIdle)
+					{
+						powerDown[i] = true;
+						(*ranks)[i]->powerDown();
+						for (size_t j=0;j<NUM_BANKS;j++)
+						{
+							bankStates[i][j].currentBankState = PowerDown;
+							bankStates[i][j].nextPowerUp = currentClockCycle + tCKE;
+						}
+					}
+				}
+				//if there IS something in the queue or there IS a refresh waiting (and we can power up), do it
+				else if (currentClockCycle >= bankStates[i][0].nextPowerUp && powerDown[i]) //use 0 since theyre all the same
 				{
-					powerDown[i] = true;
-					(*ranks)[i]->powerDown();
+					powerDown[i] = false;
+					(*ranks)[i]->powerUp();
 					for (size_t j=0;j<NUM_BANKS;j++)
 					{
-						bankStates[i][j].currentBankState = PowerDown;
-						bankStates[i][j].nextPowerUp = currentClockCycle + tCKE;
+						bankStates[i][j].currentBankState = Idle;
+						bankStates[i][j].nextActivate = currentClockCycle + tXP;
 					}
 				}
 			}
-			//if there IS something in the queue or there IS a refresh waiting (and we can power up), do it
-			else if (currentClockCycle >= bankStates[i][0].nextPowerUp && powerDown[i]) //use 0 since theyre all the same
+
+			//check for open bank
+			bool bankOpen = false;
+			for (size_t j=0;j<NUM_BANKS;j++)
 			{
-				powerDown[i] = false;
-				(*ranks)[i]->powerUp();
-				for (size_t j=0;j<NUM_BANKS;j++)
+				if (bankStates[i][j].currentBankState == Refreshing ||
+				        bankStates[i][j].currentBankState == RowActive)
 				{
-					bankStates[i][j].currentBankState = Idle;
-					bankStates[i][j].nextActivate = currentClockCycle + tXP;
+					bankOpen = true;
+					break;
 				}
 			}
-		}
 
-		//check for open bank
-		bool bankOpen = false;
-		for (size_t j=0;j<NUM_BANKS;j++)
-		{
-			if (bankStates[i][j].currentBankState == Refreshing ||
-			        bankStates[i][j].currentBankState == RowActive)
-			{
-				bankOpen = true;
-				break;
-			}
-		}
-
-		//background power is dependent on whether or not a bank is open or not
-		if (bankOpen)
-		{
-			if (DEBUG_POWER)
-			{
-				PRINT(" ++ Adding IDD3N to total energy [from rank "<< i <<"]");
-			}
-			backgroundEnergy[i] += IDD3N * NUM_DEVICES;
-		}
-		else
-		{
-			//if we're in power-down mode, use the correct current
-			if (powerDown[i])
+			//background power is dependent on whether or not a bank is open or not
+			if (bankOpen)
 			{
 				if (DEBUG_POWER)
 				{
-					PRINT(" ++ Adding IDD2P to total energy [from rank " << i << "]");
+					PRINT(" ++ Adding IDD3N to total energy [from rank "<< i <<"]");
 				}
-				backgroundEnergy[i] += IDD2P * NUM_DEVICES;
+				backgroundEnergy[i] += IDD3N * NUM_DEVICES;
 			}
 			else
 			{
-				if (DEBUG_POWER)
+				//if we're in power-down mode, use the correct current
+				if (powerDown[i])
+				{
+					if (DEBUG_POWER)
+					{
+						PRINT(" ++ Adding IDD2P to total energy [from rank " << i << "]");
+					}
+					backgroundEnergy[i] += IDD2P * NUM_DEVICES;
+				}
+				else
 				{
-					PRINT(" ++ Adding IDD2N to total energy [from rank " << i << "]");
+					if (DEBUG_POWER)
+					{
+						PRINT(" ++ Adding IDD2N to total energy [from rank " << i << "]");
+					}
+					backgroundEnergy[i] += IDD2N * NUM_DEVICES;
 				}
-				backgroundEnergy[i] += IDD2N * NUM_DEVICES;
 			}
 		}
 	}
@@ -681,6 +778,7 @@ void MemoryController::update()
 				unsigned chan,rank,bank,row,col;
 				addressMapping(returnTransaction[0]->address,chan,rank,bank,row,col);
 				insertHistogram(currentClockCycle-pendingReadTransactions[i]->timeAdded,rank,bank);
+				addLatencyStages(pendingReadTransactions[i], returnTransaction[0]);
 				//return latency
 				returnReadData(pendingReadTransactions[i]);
 
@@ -700,9 +798,17 @@ void MemoryController::update()
 	}
 
 	//decrement refresh counters
-	for (size_t i=0;i<NUM_RANKS;i++)
 	{
-		refreshCountdown[i]--;
+		PROFILE_SCOPE(PROFILE_REFRESH);
+		for (size_t i=0;i<NUM_RANKS;i++)
+		{
+			refreshCountdown[i]--;
+			//nothing else goes to a rank while it waits for a refresh or does one
+			if (commandQueue.isWaitingForRefresh(i) || bankStates[i][0].currentBankState == Refreshing)
+			{
+				refreshBlockedCycles[i]++;
+			}
+		}
 	}
 
 	//
@@ -764,6 +870,100 @@ bool MemoryController::WillAcceptTransaction()
 	return transactionQueue.size() < TRANS_QUEUE_DEPTH;
 }
 
+/*
+ * Skips cycles ahead without simulating them. The refresh counters are
+ * advanced analytically: every refresh that would have come due in the gap
+ * is counted (moving refreshRank along) and leaves its rank with all banks
+ * precharged, which is all of its effect that outlasts the gap.
+ */
+void MemoryController::fastForward(uint64_t cycles)
+{
+	uint64_t refreshPeriod = REFRESH_PERIOD/tCK;
+	uint64_t refreshes = 0;
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		uint64_t countdown = refreshCountdown[r];
+		if (countdown >= cycles)
+		{
+			refreshCountdown[r] = countdown - cycles;
+			continue;
+		}
+		// due at countdown, countdown+period, ... ; the counter restarts at each
+		uint64_t sinceFirst = cycles - 1 - countdown;
+		refreshes += 1 + sinceFirst / refreshPeriod;
+		refreshCountdown[r] = refreshPeriod - 1 - sinceFirst % refreshPeriod;
+		for (size_t b=0; b<NUM_BANKS; b++)
+		{
+			bankStates[r][b].currentBankState = Idle;
+			(*ranks)[r]->bankStates[b].currentBankState = Idle;
+		}
+	}
+	refreshRank = (refreshRank + refreshes) % NUM_RANKS;
+	commandQueue.currentClockCycle += cycles;
+	currentClockCycle += cycles;
+}
+
+/*
+ * Applies a request without timing it: under the open page policy the row
+ * it touches is left open, under close page the bank is left precharged.
+ */
+void MemoryController::functionalAccess(uint64_t address)
+{
+	unsigned chan, rank, bank, row, col;
+	addressMapping(address, chan, rank, bank, row, col);
+	//a rank that went into power down (say, idle before a checkpoint) is woken
+	//	up the way update() does it, as if tCKE had already passed
+	if (powerDown[rank])
+	{
+		Rank *r = (*ranks)[rank];
+		powerDown[rank] = false;
+		for (size_t j=0;j<NUM_BANKS;j++)
+		{
+			r->bankStates[j].nextPowerUp = min(r->bankStates[j].nextPowerUp, r->currentClockCycle);
+			bankStates[rank][j].currentBankState = Idle;
+			bankStates[rank][j].nextActivate = currentClockCycle + tXP;
+		}
+		r->powerUp();
+	}
+	BankState *states[] = {&bankStates[rank][bank], &(*ranks)[rank]->bankStates[bank]};
+	for (size_t i=0; i<2; i++)
+	{
+		if (rowBufferPolicy == OpenPage)
+		{
+			states[i]->currentBankState = RowActive;
+			states[i]->openRowAddress = row;
+			states[i]->lastCommand = ACTIVATE;
+		}
+		else
+		{
+			states[i]->currentBankState = Idle;
+			states[i]->lastCommand = PRECHARGE;
+		}
+	}
+}
+
+//true when every request handed to the controller has been fully dealt with
+bool MemoryController::isDrained() const
+{
+	if (!transactionQueue.empty() || !pendingReadTransactions.empty() ||
+			!writeDataToSend.empty() || !returnTransaction.empty())
+	{
+		return false;
+	}
+	if (outgoingCmdPacket != NULL || outgoingDataPacket != NULL)
+	{
+		return false;
+	}
+	for (size_t i=0; i<NUM_RANKS; i++)
+	{
+		if (!commandQueue.isEmpty(i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 //allows outside source to make request of memory system
 bool MemoryController::addTransaction(Transaction *trans)
 {
@@ -790,7 +990,14 @@ void MemoryController::resetStats()
 			totalReadsPerBank[SEQUENTIAL(i,j)] = 0;
 			totalWritesPerBank[SEQUENTIAL(i,j)] = 0;
 			totalEpochLatency[SEQUENTIAL(i,j)] = 0;
+			rowHitsPerBank[SEQUENTIAL(i,j)] = 0;
+			rowMissesPerBank[SEQUENTIAL(i,j)] = 0;
+			rowConflictsPerBank[SEQUENTIAL(i,j)] = 0;
+			activatesPerBank[SEQUENTIAL(i,j)] = 0;
+			prechargesPerBank[SEQUENTIAL(i,j)] = 0;
+			commandQueue.forcedCloses[i][j] = 0;
 		}
+		epochRankLatencies[i].reset();
 
 		burstEnergy[i] = 0;
 		actpreEnergy[i] = 0;
@@ -799,10 +1006,101 @@ void MemoryController::resetStats()
 		totalReadsPerRank[i] = 0;
 		totalWritesPerRank[i] = 0;
 	}
+	epochLatencies.reset();
+	epochStageLatency.assign(NUM_LATENCY_STAGES,0);
+	dataBusBusyCycles = 0;
+	turnaroundCycles = 0;
+	rankSwitchCycles = 0;
+	cmdBusBusyCycles = 0;
+	fawBlockedCycles = 0;
+	rrdBlockedCycles = 0;
+}
+
+//forgets the whole-run stats (the final latency histogram, percentiles,
+//stage breakdown and totals) so they only cover what's simulated from here
+void MemoryController::resetRunStats()
+{
+	latencies.clear();
+	runLatencies.reset();
+	runStageLatency.assign(NUM_LATENCY_STAGES,0);
+	grandTotalBankAccesses.assign(NUM_RANKS*NUM_BANKS,0);
+	totalTransactions = 0;
+	sampleTransactions = 0;
+}
+// the read latency percentiles reported in the stats and the vis file
+static const double LATENCY_PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+static const char *LATENCY_PERCENTILE_NAMES[] = {"Latency_p50", "Latency_p90", "Latency_p99", "Latency_p99_9"};
+static const size_t NUM_LATENCY_PERCENTILES = sizeof(LATENCY_PERCENTILES)/sizeof(LATENCY_PERCENTILES[0]);
+
+// in ns (nan without any reads, like the average latency)
+static double latencyPercentile(const LatencyHistogram &histogram, size_t i)
+{
+	if (histogram.count() == 0)
+	{
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	return histogram.percentile(LATENCY_PERCENTILES[i]) * tCK;
+}
+
+static string formatPercentiles(const LatencyHistogram &histogram)
+{
+	stringstream line;
+	line.precision(3);
+	line.setf(ios::fixed,ios::floatfield);
+	for (size_t i=0; i<NUM_LATENCY_PERCENTILES; i++)
+	{
+		line << (i > 0 ? " / " : "") << latencyPercentile(histogram, i);
+	}
+	line << " ns";
+	return line.str();
+}
+
+// the stages of the read latency breakdown (see addLatencyStages())
+static const char *LATENCY_STAGE_NAMES[] = {"Latency_Pending", "Latency_Transaction_Queue", "Latency_ACT_Wait",
+	"Latency_Refresh", "Latency_CAS_Wait", "Latency_Data"};
+
+// average per read in ns (nan without any reads)
+static double averageStageLatency(const vector<uint64_t> &stageLatency, uint64_t reads, size_t stage)
+{
+	return ((double)stageLatency[stage] / (double)reads) * tCK;
+}
+
+static string formatStages(const vector<uint64_t> &stageLatency, uint64_t reads)
+{
+	stringstream line;
+	line.precision(3);
+	line.setf(ios::fixed,ios::floatfield);
+	for (size_t i=0; i<MemoryController::NUM_LATENCY_STAGES; i++)
+	{
+		line << (i > 0 ? " / " : "") << averageStageLatency(stageLatency, reads, i);
+	}
+	line << " ns";
+	return line.str();
+}
+
+//fills in the occupancy of the queues now and the bandwidth since the previous sample
+void MemoryController::takeSample(Sample &sample)
+{
+	sample.cycle = currentClockCycle;
+	sample.channel = parentMemorySystem->systemID;
+	sample.transactionQueue = transactionQueue.size();
+	sample.commandQueue = commandQueue.size();
+	sample.outstandingReads = pendingReadTransactions.size();
+	sample.bandwidth = 0.0;
+	if (currentClockCycle > sampleCycle)
+	{
+		unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+		double seconds = (double)(currentClockCycle - sampleCycle) * tCK * 1E-9;
+		sample.bandwidth = (((double)(totalTransactions - sampleTransactions) * bytesPerTransaction)/(1024.0*1024.0*1024.0)) / seconds;
+	}
+	sampleTransactions = totalTransactions;
+	sampleCycle = currentClockCycle;
 }
+
 //prints statistics at the end of an epoch or  simulation
 void MemoryController::printStats(bool finalStats)
 {
+	PROFILE_SCOPE(PROFILE_STATS);
 	unsigned myChannel = parentMemorySystem->systemID;
 
 	//if we are not at the end of the epoch, make sure to adjust for the actual number of cycles elapsed
@@ -847,6 +1145,17 @@ void MemoryController::printStats(bool finalStats)
 	PRINT( " ============== Printing Statistics [id:"<<parentMemorySystem->systemID<<"]==============" );
 	PRINTN( "   Total Return Transactions : " << totalTransactions );
 	PRINT( " ("<<totalBytesTransferred <<" bytes) aggregate average bandwidth "<<totalBandwidth<<"GB/s");
+	PRINT( "   Read latency p50/p90/p99/p99.9 : "<<formatPercentiles(epochLatencies));
+	PRINT( "   Read latency pending/trans queue/ACT/refresh/CAS/data : "<<formatStages(epochStageLatency, epochLatencies.count()));
+	// as a percentage of every cycle of the epoch
+	double dataBusUtilization = 100.0 * dataBusBusyCycles / cyclesElapsed;
+	double turnaroundBubbles = 100.0 * turnaroundCycles / cyclesElapsed;
+	double rankSwitchBubbles = 100.0 * rankSwitchCycles / cyclesElapsed;
+	double cmdBusUtilization = 100.0 * cmdBusBusyCycles / cyclesElapsed;
+	double fawBlocked = 100.0 * fawBlockedCycles / cyclesElapsed;
+	double rrdBlocked = 100.0 * rrdBlockedCycles / cyclesElapsed;
+	PRINT( "   Data bus busy/turnaround/rank switch : "<<dataBusUtilization<<" / "<<turnaroundBubbles<<" / "<<rankSwitchBubbles<<" %");
+	PRINT( "   Command bus busy/idle for tFAW/idle for tRRD : "<<cmdBusUtilization<<" / "<<fawBlocked<<" / "<<rrdBlocked<<" %");
 
 	double totalAggregateBandwidth = 0.0;	
 	for (size_t r=0;r<NUM_RANKS;r++)
@@ -857,6 +1166,19 @@ void MemoryController::printStats(bool finalStats)
 		PRINT( " ("<<totalReadsPerRank[r] * bytesPerTransaction<<" bytes)");
 		PRINTN( "        -Writes : " << totalWritesPerRank[r]);
 		PRINT( " ("<<totalWritesPerRank[r] * bytesPerTransaction<<" bytes)");
+		PRINT( "        -Read latency p50/p90/p99/p99.9 : "<<formatPercentiles(epochRankLatencies[r]));
+		uint64_t rankHits=0, rankMisses=0, rankConflicts=0, rankActivates=0, rankPrecharges=0, rankForcedCloses=0;
+		for (size_t j=0;j<NUM_BANKS;j++)
+		{
+			rankHits += rowHitsPerBank[SEQUENTIAL(r,j)];
+			rankMisses += rowMissesPerBank[SEQUENTIAL(r,j)];
+			rankConflicts += rowConflictsPerBank[SEQUENTIAL(r,j)];
+			rankActivates += activatesPerBank[SEQUENTIAL(r,j)];
+			rankPrecharges += prechargesPerBank[SEQUENTIAL(r,j)];
+			rankForcedCloses += commandQueue.forcedCloses[r][j];
+		}
+		PRINTN( "        -Row hits/misses/conflicts : " << rankHits << " / " << rankMisses << " / " << rankConflicts);
+		PRINT( " (ACT "<<rankActivates<<", PRE "<<rankPrecharges<<", forced closes "<<rankForcedCloses<<")");
 		for (size_t j=0;j<NUM_BANKS;j++)
 		{
 			PRINT( "        -Bandwidth / Latency  (Bank " <<j<<"): " <<bandwidth[SEQUENTIAL(r,j)] << " GB/s\t\t" <<averageLatency[SEQUENTIAL(r,j)] << " ns");
@@ -896,34 +1218,64 @@ void MemoryController::printStats(bool finalStats)
 				totalRankBandwidth += bandwidth[SEQUENTIAL(r,b)];
 				totalAggregateBandwidth += bandwidth[SEQUENTIAL(r,b)];
 				csvOut << CSVWriter::IndexedName("Average_Latency",myChannel,r,b) << averageLatency[SEQUENTIAL(r,b)];
+				csvOut << CSVWriter::IndexedName("Row_Hits",myChannel,r,b) << rowHitsPerBank[SEQUENTIAL(r,b)];
+				csvOut << CSVWriter::IndexedName("Row_Misses",myChannel,r,b) << rowMissesPerBank[SEQUENTIAL(r,b)];
+				csvOut << CSVWriter::IndexedName("Row_Conflicts",myChannel,r,b) << rowConflictsPerBank[SEQUENTIAL(r,b)];
+				csvOut << CSVWriter::IndexedName("ACT_Count",myChannel,r,b) << activatesPerBank[SEQUENTIAL(r,b)];
+				csvOut << CSVWriter::IndexedName("PRE_Count",myChannel,r,b) << prechargesPerBank[SEQUENTIAL(r,b)];
+				csvOut << CSVWriter::IndexedName("Forced_Row_Closes",myChannel,r,b) << commandQueue.forcedCloses[r][b];
 			}
 			csvOut << CSVWriter::IndexedName("Rank_Aggregate_Bandwidth",myChannel,r) << totalRankBandwidth; 
 			csvOut << CSVWriter::IndexedName("Rank_Average_Bandwidth",myChannel,r) << totalRankBandwidth/NUM_RANKS; 
+			for (size_t i=0; i<NUM_LATENCY_PERCENTILES; i++)
+			{
+				csvOut << CSVWriter::IndexedName(LATENCY_PERCENTILE_NAMES[i],myChannel,r) << latencyPercentile(epochRankLatencies[r], i);
+			}
 		}
 	}
 	if (VIS_FILE_OUTPUT)
 	{
 		csvOut << CSVWriter::IndexedName("Aggregate_Bandwidth",myChannel) << totalAggregateBandwidth;
 		csvOut << CSVWriter::IndexedName("Average_Bandwidth",myChannel) << totalAggregateBandwidth / (NUM_RANKS*NUM_BANKS);
+		for (size_t i=0; i<NUM_LATENCY_PERCENTILES; i++)
+		{
+			csvOut << CSVWriter::IndexedName(LATENCY_PERCENTILE_NAMES[i],myChannel) << latencyPercentile(epochLatencies, i);
+		}
+		for (size_t i=0; i<NUM_LATENCY_STAGES; i++)
+		{
+			csvOut << CSVWriter::IndexedName(LATENCY_STAGE_NAMES[i],myChannel) << averageStageLatency(epochStageLatency, epochLatencies.count(), i);
+		}
+		csvOut << CSVWriter::IndexedName("Data_Bus_Utilization",myChannel) << dataBusUtilization;
+		csvOut << CSVWriter::IndexedName("Turnaround_Bubbles",myChannel) << turnaroundBubbles;
+		csvOut << CSVWriter::IndexedName("Rank_Switch_Bubbles",myChannel) << rankSwitchBubbles;
+		csvOut << CSVWriter::IndexedName("Command_Bus_Utilization",myChannel) << cmdBusUtilization;
+		csvOut << CSVWriter::IndexedName("tFAW_Blocked",myChannel) << fawBlocked;
+		csvOut << CSVWriter::IndexedName("tRRD_Blocked",myChannel) << rrdBlocked;
 	}
 
 	// only print the latency histogram at the end of the simulation since it clogs the output too much to print every epoch
 	if (finalStats)
 	{
-		PRINT( " ---  Latency list ("<<latencies.size()<<")");
+		PRINT( " ---  Read latency p50/p90/p99/p99.9 (whole run) : "<<formatPercentiles(runLatencies));
+		PRINT( " ---  Read latency pending/trans queue/ACT/refresh/CAS/data (whole run) : "<<formatStages(runStageLatency, runLatencies.count()));
+		PRINT( " ---  Latency list ("<<(latencies.size() - count(latencies.begin(), latencies.end(), 0))<<")");
 		PRINT( "       [lat] : #");
 		if (VIS_FILE_OUTPUT)
 		{
 			csvOut.getOutputStream() << "!!HISTOGRAM_DATA"<<endl;
 		}
 
-		map<unsigned,unsigned>::iterator it; //
-		for (it=latencies.begin(); it!=latencies.end(); it++)
+		for (size_t bin=0; bin<latencies.size(); bin++)
 		{
-			PRINT( "       ["<< it->first <<"-"<<it->first+(HISTOGRAM_BIN_SIZE-1)<<"] : "<< it->second );
+			if (latencies[bin] == 0)
+			{
+				continue;
+			}
+			unsigned latency = bin * HISTOGRAM_BIN_SIZE;
+			PRINT( "       ["<< latency <<"-"<<latency+(HISTOGRAM_BIN_SIZE-1)<<"] : "<< latencies[bin] );
 			if (VIS_FILE_OUTPUT)
 			{
-				csvOut.getOutputStream() << it->first <<"="<< it->second << endl;
+				csvOut.getOutputStream() << latency <<"="<< latencies[bin] << endl;
 			}
 		}
 		if (currentClockCycle % EPOCH_LENGTH == 0)
@@ -969,10 +1321,256 @@ MemoryController::~MemoryController()
 	}
 
 }
+/*
+ * Everything needed to pick up on the next cycle exactly where this one left
+ * off: the bank states, both queues, every packet and transaction in flight
+ * and the stats and energy counters. poppedBusPacket is left out on purpose;
+ * it only points at a command for the rest of the cycle it was popped in.
+ */
+void MemoryController::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_CONTROLLER);
+	checkpoint.write(currentClockCycle);
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		for (size_t b=0; b<NUM_BANKS; b++)
+		{
+			bankStates[r][b].saveState(checkpoint);
+		}
+	}
+	commandQueue.saveState(checkpoint);
+
+	checkpoint.write<uint64_t>(transactionQueue.size());
+	for (size_t i=0; i<transactionQueue.size(); i++)
+	{
+		checkpoint.writeTransaction(transactionQueue[i]);
+	}
+	checkpoint.write<uint64_t>(pendingReadTransactions.size());
+	for (size_t i=0; i<pendingReadTransactions.size(); i++)
+	{
+		checkpoint.writeTransaction(pendingReadTransactions[i]);
+	}
+	checkpoint.write<uint64_t>(returnTransaction.size());
+	for (size_t i=0; i<returnTransaction.size(); i++)
+	{
+		checkpoint.writeTransaction(returnTransaction[i]);
+	}
+	checkpoint.write<uint64_t>(writeDataToSend.size());
+	for (size_t i=0; i<writeDataToSend.size(); i++)
+	{
+		checkpoint.writePacket(writeDataToSend[i]);
+	}
+	checkpoint.writeVector(writeDataCountdown);
+	checkpoint.writeVector(refreshCountdown);
+	checkpoint.writeVector(powerDown);
+	checkpoint.write(refreshRank);
+
+	checkpoint.writePacket(outgoingCmdPacket);
+	checkpoint.write(cmdCyclesLeft);
+	checkpoint.writePacket(outgoingDataPacket);
+	checkpoint.write(dataCyclesLeft);
+
+	checkpoint.writeVector(latencies);
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		epochRankLatencies[r].saveState(checkpoint);
+	}
+	epochLatencies.saveState(checkpoint);
+	runLatencies.saveState(checkpoint);
+	checkpoint.writeVector(refreshBlockedCycles);
+	checkpoint.writeVector(epochStageLatency);
+	checkpoint.writeVector(runStageLatency);
+	checkpoint.write(totalTransactions);
+	checkpoint.writeVector(grandTotalBankAccesses);
+	checkpoint.writeVector(totalReadsPerBank);
+	checkpoint.writeVector(totalWritesPerBank);
+	checkpoint.writeVector(totalReadsPerRank);
+	checkpoint.writeVector(totalWritesPerRank);
+	checkpoint.writeVector(totalEpochLatency);
+	checkpoint.writeVector(rowHitsPerBank);
+	checkpoint.writeVector(rowMissesPerBank);
+	checkpoint.writeVector(rowConflictsPerBank);
+	checkpoint.writeVector(activatesPerBank);
+	checkpoint.writeVector(prechargesPerBank);
+	checkpoint.writeVector(rowClosedTime);
+	checkpoint.write(dataBusBusyCycles);
+	checkpoint.write(turnaroundCycles);
+	checkpoint.write(rankSwitchCycles);
+	checkpoint.write(cmdBusBusyCycles);
+	checkpoint.write(fawBlockedCycles);
+	checkpoint.write(rrdBlockedCycles);
+	checkpoint.write(dataBusFreeTime);
+	checkpoint.write(lastBurstRank);
+	checkpoint.write(lastBurstWasRead);
+	checkpoint.write(sampleTransactions);
+	checkpoint.write(sampleCycle);
+	checkpoint.writeVector(backgroundEnergy);
+	checkpoint.writeVector(burstEnergy);
+	checkpoint.writeVector(actpreEnergy);
+	checkpoint.writeVector(refreshEnergy);
+}
+
+void MemoryController::restoreState(CheckpointReader &checkpoint)
+{
+	uint64_t size;
+
+	checkpoint.readSection(CHECKPOINT_CONTROLLER);
+	checkpoint.read(currentClockCycle);
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		for (size_t b=0; b<NUM_BANKS; b++)
+		{
+			bankStates[r][b].restoreState(checkpoint);
+		}
+	}
+	commandQueue.restoreState(checkpoint);
+
+	for (size_t i=0; i<transactionQueue.size(); i++)
+	{
+		delete transactionQueue[i];
+	}
+	checkpoint.read(size);
+	transactionQueue.resize(size);
+	for (size_t i=0; i<size; i++)
+	{
+		transactionQueue[i] = checkpoint.readTransaction();
+	}
+	for (size_t i=0; i<pendingReadTransactions.size(); i++)
+	{
+		delete pendingReadTransactions[i];
+	}
+	checkpoint.read(size);
+	pendingReadTransactions.resize(size);
+	for (size_t i=0; i<size; i++)
+	{
+		pendingReadTransactions[i] = checkpoint.readTransaction();
+	}
+	for (size_t i=0; i<returnTransaction.size(); i++)
+	{
+		delete returnTransaction[i];
+	}
+	checkpoint.read(size);
+	returnTransaction.resize(size);
+	for (size_t i=0; i<size; i++)
+	{
+		returnTransaction[i] = checkpoint.readTransaction();
+	}
+	for (size_t i=0; i<writeDataToSend.size(); i++)
+	{
+		delete writeDataToSend[i];
+	}
+	checkpoint.read(size);
+	writeDataToSend.resize(size);
+	for (size_t i=0; i<size; i++)
+	{
+		writeDataToSend[i] = checkpoint.readPacket(dramsim_log);
+	}
+	checkpoint.readVector(writeDataCountdown);
+	checkpoint.readVector(refreshCountdown);
+	checkpoint.readVector(powerDown);
+	checkpoint.read(refreshRank);
+
+	delete outgoingCmdPacket;
+	outgoingCmdPacket = checkpoint.readPacket(dramsim_log);
+	checkpoint.read(cmdCyclesLeft);
+	delete outgoingDataPacket;
+	outgoingDataPacket = checkpoint.readPacket(dramsim_log);
+	checkpoint.read(dataCyclesLeft);
+	poppedBusPacket = NULL;
+
+	checkpoint.readVector(latencies);
+	for (size_t r=0; r<NUM_RANKS; r++)
+	{
+		epochRankLatencies[r].restoreState(checkpoint);
+	}
+	epochLatencies.restoreState(checkpoint);
+	runLatencies.restoreState(checkpoint);
+	checkpoint.readVector(refreshBlockedCycles);
+	checkpoint.readVector(epochStageLatency);
+	checkpoint.readVector(runStageLatency);
+	checkpoint.read(totalTransactions);
+	checkpoint.readVector(grandTotalBankAccesses);
+	checkpoint.readVector(totalReadsPerBank);
+	checkpoint.readVector(totalWritesPerBank);
+	checkpoint.readVector(totalReadsPerRank);
+	checkpoint.readVector(totalWritesPerRank);
+	checkpoint.readVector(totalEpochLatency);
+	checkpoint.readVector(rowHitsPerBank);
+	checkpoint.readVector(rowMissesPerBank);
+	checkpoint.readVector(rowConflictsPerBank);
+	checkpoint.readVector(activatesPerBank);
+	checkpoint.readVector(prechargesPerBank);
+	checkpoint.readVector(rowClosedTime);
+	checkpoint.read(dataBusBusyCycles);
+	checkpoint.read(turnaroundCycles);
+	checkpoint.read(rankSwitchCycles);
+	checkpoint.read(cmdBusBusyCycles);
+	checkpoint.read(fawBlockedCycles);
+	checkpoint.read(rrdBlockedCycles);
+	checkpoint.read(dataBusFreeTime);
+	checkpoint.read(lastBurstRank);
+	checkpoint.read(lastBurstWasRead);
+	checkpoint.read(sampleTransactions);
+	checkpoint.read(sampleCycle);
+	checkpoint.readVector(backgroundEnergy);
+	checkpoint.readVector(burstEnergy);
+	checkpoint.readVector(actpreEnergy);
+	checkpoint.readVector(refreshEnergy);
+}
+
 //inserts a latency into the latency histogram
 void MemoryController::insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank)
 {
 	totalEpochLatency[SEQUENTIAL(rank,bank)] += latencyValue;
 	//poor man's way to bin things.
-	latencies[(latencyValue/HISTOGRAM_BIN_SIZE)*HISTOGRAM_BIN_SIZE]++;
+	unsigned bin = latencyValue/HISTOGRAM_BIN_SIZE;
+	if (bin >= latencies.size())
+	{
+		latencies.resize(bin+1, 0);
+	}
+	latencies[bin]++;
+	epochRankLatencies[rank].add(latencyValue);
+	epochLatencies.add(latencyValue);
+	runLatencies.add(latencyValue);
+}
+
+//splits the latency of a read into the stages it went through; request is the
+//	pending read, returned carries the times from its bus packet
+void MemoryController::addLatencyStages(const Transaction *request, const Transaction *returned)
+{
+	uint64_t stages[NUM_LATENCY_STAGES];
+	stages[0] = request->timeAdded - request->timeCreated;
+	stages[1] = request->timeScheduled - request->timeAdded;
+	stages[2] = (returned->timeActivated - request->timeScheduled) - returned->refreshBeforeActivate;
+	stages[3] = returned->refreshBeforeActivate + returned->refreshBeforeIssue;
+	stages[4] = (returned->timeIssued - returned->timeActivated) - returned->refreshBeforeIssue;
+	stages[5] = currentClockCycle - returned->timeIssued;
+	for (size_t i=0; i<NUM_LATENCY_STAGES; i++)
+	{
+		epochStageLatency[i] += stages[i];
+		runStageLatency[i] += stages[i];
+	}
+}
+
+//books the data burst of a column command that was just issued; an idle gap
+//	before it counts as a turnaround or rank switch bubble up to the gap the
+//	timing rules require for that switch
+void MemoryController::addDataBurst(const BusPacket *columnCommand)
+{
+	bool isRead = columnCommand->busPacketType == READ || columnCommand->busPacketType == READ_P;
+	uint64_t start = currentClockCycle + (isRead ? RL : WL);
+	uint64_t gap = start > dataBusFreeTime ? start - dataBusFreeTime : 0;
+	if (isRead != lastBurstWasRead)
+	{
+		uint64_t required = (isRead && columnCommand->rank == lastBurstRank) ? tWTR + RL : tRTRS;
+		turnaroundCycles += min(gap, required);
+	}
+	else if (columnCommand->rank != lastBurstRank)
+	{
+		rankSwitchCycles += min(gap, (uint64_t)tRTRS);
+	}
+	dataBusBusyCycles += BL/2;
+	dataBusFreeTime = start + BL/2;
+	lastBurstRank = columnCommand->rank;
+	lastBurstWasRead = isRead;
 }
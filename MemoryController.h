@@ -45,6 +45,8 @@
 #include "BankState.h"
 #include "Rank.h"
 #include "CSVWriter.h"
+#include "LatencyHistogram.h"
+#include "Sampler.h"
 #include <map>
 
 using namespace std;
@@ -52,6 +54,8 @@ using namespace std;
 namespace DRAMSim
 {
 class MemorySystem;
+class CheckpointWriter;
+class CheckpointReader;
 class MemoryController : public SimulatorObject
 {
 
@@ -62,21 +66,31 @@ public:
 
 	bool addTransaction(Transaction *trans);
 	bool WillAcceptTransaction();
+	bool isDrained() const;
+	void fastForward(uint64_t cycles);
+	void functionalAccess(uint64_t address);
 	void returnReadData(const Transaction *trans);
 	void receiveFromBus(BusPacket *bpacket);
 	void attachRanks(vector<Rank *> *ranks);
 	void update();
 	void printStats(bool finalStats = false);
+	void takeSample(Sample &sample);
 	void resetStats(); 
+	void resetRunStats();
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
 
 
 	//fields
 	vector<Transaction *> transactionQueue;
+	static const size_t NUM_LATENCY_STAGES = 6;
 private:
 	ostream &dramsim_log;
 	vector< vector <BankState> > bankStates;
 	//functions
 	void insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank);
+	void addLatencyStages(const Transaction *request, const Transaction *returned);
+	void addDataBurst(const BusPacket *columnCommand);
 
 	//fields
 	MemorySystem *parentMemorySystem;
@@ -88,7 +102,19 @@ private:
 	vector<unsigned> writeDataCountdown;
 	vector<Transaction *> returnTransaction;
 	vector<Transaction *> pendingReadTransactions;
-	map<unsigned,unsigned> latencies; // latencyValue -> latencyCount
+	vector<uint64_t> latencies; // latencyValue/HISTOGRAM_BIN_SIZE -> latencyCount
+	// for the percentiles: this epoch per rank and for the channel, and the whole run
+	vector<LatencyHistogram> epochRankLatencies;
+	LatencyHistogram epochLatencies;
+	LatencyHistogram runLatencies;
+	// cycles each rank has spent waiting for or doing a refresh; column
+	// commands note it down so the breakdown can take those cycles out
+	vector<uint64_t> refreshBlockedCycles;
+	// read latency (cycles) summed by stage over this epoch's and the run's reads:
+	// pending in the memory system, transaction queue, waiting for the ACT,
+	// held for a refresh, waiting for the CAS, and CAS to data returned
+	vector<uint64_t> epochStageLatency;
+	vector<uint64_t> runStageLatency;
 	vector<bool> powerDown;
 
 	vector<Rank *> *ranks;
@@ -103,6 +129,9 @@ private:
 	unsigned dataCyclesLeft;
 
 	uint64_t totalTransactions;
+	// totalTransactions and the cycle at the previous takeSample()
+	uint64_t sampleTransactions;
+	uint64_t sampleCycle;
 	vector<uint64_t> grandTotalBankAccesses; 
 	vector<uint64_t> totalReadsPerBank;
 	vector<uint64_t> totalWritesPerBank;
@@ -110,6 +139,31 @@ private:
 	vector<uint64_t> totalReadsPerRank;
 	vector<uint64_t> totalWritesPerRank;
 
+	// row buffer outcomes of this epoch's reads and writes and the ACTs and
+	// PREs (auto-precharges included) per bank; a conflict is an access
+	// whose bank had a row open that had to be closed after it arrived
+	vector<uint64_t> rowHitsPerBank;
+	vector<uint64_t> rowMissesPerBank;
+	vector<uint64_t> rowConflictsPerBank;
+	vector<uint64_t> activatesPerBank;
+	vector<uint64_t> prechargesPerBank;
+	// when each bank last closed a row
+	vector<uint64_t> rowClosedTime;
+
+	// bus utilization this epoch (cycles): data bus bursts, bubbles between
+	// bursts for a read/write turnaround or a switch of rank, command bus
+	// busy, and no command at all while an activate was held by tFAW / tRRD
+	uint64_t dataBusBusyCycles;
+	uint64_t turnaroundCycles;
+	uint64_t rankSwitchCycles;
+	uint64_t cmdBusBusyCycles;
+	uint64_t fawBlockedCycles;
+	uint64_t rrdBlockedCycles;
+	// the last burst put on the data bus
+	uint64_t dataBusFreeTime;
+	unsigned lastBurstRank;
+	bool lastBurstWasRead;
+
 
 	vector< uint64_t > totalEpochLatency;
 
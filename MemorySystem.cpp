@@ -38,6 +38,8 @@
 
 #include "MemorySystem.h"
 #include "IniReader.h"
+#include "Checkpoint.h"
+#include "CommandTrace.h"
 #include <unistd.h>
 
 using namespace std;
@@ -57,7 +59,8 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, CSVWriter &cs
 		ReturnReadData(NULL),
 		WriteDataDone(NULL),
 		systemID(id),
-		csvOut(csvOut_)
+		csvOut(csvOut_),
+		commandTrace(NULL)
 {
 	currentClockCycle = 0;
 
@@ -161,6 +164,7 @@ MemorySystem::~MemorySystem()
 	}
 	ranks->clear();
 	delete(ranks);
+	delete commandTrace;
 
 	if (VERIFICATION_OUTPUT)
 	{
@@ -169,15 +173,68 @@ MemorySystem::~MemorySystem()
 	}
 }
 
+void MemorySystem::startCommandTrace(const string &filename)
+{
+	stopCommandTrace();
+	commandTrace = new CommandTrace(filename, systemID);
+	for (size_t i=0; i<NUM_RANKS; i++)
+	{
+		(*ranks)[i]->commandTrace = commandTrace;
+	}
+}
+
+//writes out what the command trace has and closes its file
+void MemorySystem::stopCommandTrace()
+{
+	delete commandTrace;
+	commandTrace = NULL;
+	for (size_t i=0; i<NUM_RANKS; i++)
+	{
+		(*ranks)[i]->commandTrace = NULL;
+	}
+}
+
 bool MemorySystem::WillAcceptTransaction()
 {
 	return memoryController->WillAcceptTransaction();
 }
 
+void MemorySystem::fastForward(uint64_t cycles)
+{
+	for (size_t i=0; i<NUM_RANKS; i++)
+	{
+		(*ranks)[i]->currentClockCycle += cycles;
+	}
+	memoryController->fastForward(cycles);
+	currentClockCycle += cycles;
+}
+
+void MemorySystem::functionalAccess(uint64_t address)
+{
+	memoryController->functionalAccess(address);
+}
+
+bool MemorySystem::isDrained() const
+{
+	if (!pendingTransactions.empty() || !memoryController->isDrained())
+	{
+		return false;
+	}
+	for (size_t i=0; i<ranks->size(); i++)
+	{
+		if (!(*ranks)[i]->isDrained())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 bool MemorySystem::addTransaction(bool isWrite, uint64_t addr)
 {
 	TransactionType type = isWrite ? DATA_WRITE : DATA_READ;
 	Transaction *trans = new Transaction(type,addr,NULL);
+	trans->timeCreated = currentClockCycle;
 	// push_back in memoryController will make a copy of this during
 	// addTransaction so it's kosher for the reference to be local 
 
@@ -194,6 +251,7 @@ bool MemorySystem::addTransaction(bool isWrite, uint64_t addr)
 
 bool MemorySystem::addTransaction(Transaction *trans)
 {
+	trans->timeCreated = currentClockCycle;
 	return memoryController->addTransaction(trans);
 }
 
@@ -203,6 +261,11 @@ void MemorySystem::printStats(bool finalStats)
 	memoryController->printStats(finalStats);
 }
 
+void MemorySystem::resetRunStats()
+{
+	memoryController->resetRunStats();
+}
+
 
 //update the memory systems state
 void MemorySystem::update()
@@ -245,6 +308,44 @@ void MemorySystem::RegisterCallbacks( Callback_t* readCB, Callback_t* writeCB,
 	ReportPower = reportPower;
 }
 
+void MemorySystem::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_CHANNEL);
+	checkpoint.write(currentClockCycle);
+	checkpoint.write<uint64_t>(pendingTransactions.size());
+	for (size_t i=0; i<pendingTransactions.size(); i++)
+	{
+		checkpoint.writeTransaction(pendingTransactions[i]);
+	}
+	memoryController->saveState(checkpoint);
+	for (size_t i=0; i<NUM_RANKS; i++)
+	{
+		(*ranks)[i]->saveState(checkpoint);
+	}
+}
+
+void MemorySystem::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readSection(CHECKPOINT_CHANNEL);
+	checkpoint.read(currentClockCycle);
+	for (size_t i=0; i<pendingTransactions.size(); i++)
+	{
+		delete pendingTransactions[i];
+	}
+	pendingTransactions.clear();
+	uint64_t size;
+	checkpoint.read(size);
+	for (size_t i=0; i<size; i++)
+	{
+		pendingTransactions.push_back(checkpoint.readTransaction());
+	}
+	memoryController->restoreState(checkpoint);
+	for (size_t i=0; i<NUM_RANKS; i++)
+	{
+		(*ranks)[i]->restoreState(checkpoint);
+	}
+}
+
 } /*namespace DRAMSim */
 
 
@@ -50,6 +50,10 @@
 namespace DRAMSim
 {
 typedef CallbackBase<void,unsigned,uint64_t,uint64_t> Callback_t;
+class CheckpointWriter;
+class CheckpointReader;
+class CommandTrace;
+
 class MemorySystem : public SimulatorObject
 {
 	ostream &dramsim_log;
@@ -61,7 +65,15 @@ public:
 	bool addTransaction(Transaction *trans);
 	bool addTransaction(bool isWrite, uint64_t addr);
 	void printStats(bool finalStats);
+	void resetRunStats();
 	bool WillAcceptTransaction();
+	bool isDrained() const;
+	void fastForward(uint64_t cycles);
+	void functionalAccess(uint64_t address);
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
+	void startCommandTrace(const string &filename);
+	void stopCommandTrace();
 	void RegisterCallbacks(
 	    Callback_t *readDone,
 	    Callback_t *writeDone,
@@ -82,6 +94,8 @@ public:
 
 private:
 	CSVWriter &csvOut;
+	// shared by the ranks (NULL unless COMMAND_TRACE_OUTPUT is set)
+	CommandTrace *commandTrace;
 };
 }
 
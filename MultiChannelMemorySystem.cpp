@@ -35,8 +35,13 @@
 #include <sys/types.h>
 
 #include "MultiChannelMemorySystem.h"
+#include "RequestRecorder.h"
+#include "Checkpoint.h"
 #include "AddressMapping.h"
 #include "IniReader.h"
+#include "AnalyticalModel.h"
+#include "Sampler.h"
+#include "Profiler.h"
 
 
 
@@ -44,11 +49,23 @@ using namespace DRAMSim;
 
 
 MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilename_, const string &systemIniFilename_, const string &pwd_, const string &traceFilename_, unsigned megsOfMemory_, string *visFilename_, const IniReader::OverrideMap *paramOverrides)
-	:megsOfMemory(megsOfMemory_), deviceIniFilename(deviceIniFilename_),
+	:dramsim_log(&logBuffer),
+	megsOfMemory(megsOfMemory_), deviceIniFilename(deviceIniFilename_),
 	systemIniFilename(systemIniFilename_), traceFilename(traceFilename_),
 	pwd(pwd_), visFilename(visFilename_), 
 	clockDomainCrosser(new ClockDomain::Callback<MultiChannelMemorySystem, void>(this, &MultiChannelMemorySystem::actual_update)),
-	csvOut(new CSVWriter(visDataOut))
+	csvOut(new CSVWriter(visDataOut)),
+	sampler(NULL),
+	recorder(NULL),
+	analyticalModel(NULL),
+	analyticalEngine(false),
+	readDone(NULL),
+	writeDone(NULL),
+	reportPower(NULL),
+	calibrationReadDone(NULL),
+	calibrationWriteDone(NULL),
+	singleChannel(false),
+	onlyChannel(0)
 {
 	currentClockCycle=0; 
 	if (visFilename)
@@ -99,6 +116,13 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string &deviceIniFilena
 		MemorySystem *channel = new MemorySystem(i, megsOfMemory/NUM_CHANS, (*csvOut), dramsim_log);
 		channels.push_back(channel);
 	}
+
+	// lets a host simulator be recorded without changing its code
+	char *recordFilename = getenv("DRAMSIM_RECORD");
+	if (recordFilename != NULL && recordFilename[0] != '\0')
+	{
+		startRecording(string(recordFilename));
+	}
 }
 /* Initialize the ClockDomainCrosser to use the CPU speed 
 	If cpuClkFreqHz == 0, then assume a 1:1 ratio (like for TraceBasedSim)
@@ -109,6 +133,163 @@ void MultiChannelMemorySystem::setCPUClockSpeed(uint64_t cpuClkFreqHz)
 	uint64_t dramsimClkFreqHz = (uint64_t)(1.0/(tCK*1e-9));
 	clockDomainCrosser.clock1 = dramsimClkFreqHz; 
 	clockDomainCrosser.clock2 = (cpuClkFreqHz == 0) ? dramsimClkFreqHz : cpuClkFreqHz; 
+	if (recorder)
+	{
+		recorder->setClocks(clockDomainCrosser.clock1, clockDomainCrosser.clock2);
+	}
+}
+
+/*
+ * Every request accepted from now on is written to filename along with the
+ * CPU cycle it was made on; TraceBasedSim --replay plays it back.
+ */
+void MultiChannelMemorySystem::startRecording(const string &filename)
+{
+	stopRecording();
+	uint64_t dramsimClkFreqHz = (uint64_t)(1.0/(tCK*1e-9));
+	// until setCPUClockSpeed() is called the crosser runs 1:1
+	uint64_t cpuClkFreqHz = (clockDomainCrosser.clock1 == clockDomainCrosser.clock2) ? dramsimClkFreqHz : clockDomainCrosser.clock2;
+	recorder = new RequestRecorder(filename, dramsimClkFreqHz, cpuClkFreqHz);
+	DEBUG("== Recording requests to '"<<filename<<"' == ");
+}
+
+void MultiChannelMemorySystem::stopRecording()
+{
+	if (recorder)
+	{
+		DEBUG("== Recorded "<<recorder->recordsWritten<<" requests to '"<<recorder->filename<<"' == ");
+		delete recorder;
+		recorder = NULL;
+	}
+}
+
+/*
+ * A checkpoint holds the complete state of every channel plus the clock
+ * crossing counters, so a memory system created from the same ini files
+ * and restored from it continues exactly as the saved one would have. The
+ * CPU:DRAM clock ratio is part of the saved state. Callbacks, output files
+ * and the request recorder are not; they belong to whoever restores it.
+ */
+void MultiChannelMemorySystem::saveCheckpoint(const string &filename) const
+{
+	CheckpointWriter checkpoint(filename);
+	saveState(checkpoint);
+	checkpoint.writeSection(CHECKPOINT_END);
+	checkpoint.close();
+	DEBUG("== Saved checkpoint at cycle "<<currentClockCycle<<" to '"<<filename<<"' == ");
+}
+
+void MultiChannelMemorySystem::restoreCheckpoint(const string &filename)
+{
+	CheckpointReader checkpoint(filename);
+	restoreState(checkpoint);
+	checkpoint.readSection(CHECKPOINT_END);
+	DEBUG("== Restored checkpoint from '"<<filename<<"' at cycle "<<currentClockCycle<<" == ");
+}
+
+/*
+ * Sends the vis output to a new file from here on; the new file starts with
+ * the ini values as they are now and its own CSV header. The samples and
+ * command traces (stopped by prepareFork()) start again under the new name.
+ * Used to give each variant forked off a warmed-up simulation its own
+ * results.
+ */
+void MultiChannelMemorySystem::redirectVisFile(string *visFilename_)
+{
+	visFilename = visFilename_;
+	if (VIS_FILE_OUTPUT)
+	{
+		visDataOut.close();
+		visDataOut.clear();
+		visBinaryOut.close();
+		visBinaryOut.clear();
+		csvOut->setBinaryOutput(NULL);
+		csvOut->reset();
+	}
+	InitOutputFiles(traceFilename);
+}
+
+/*
+ * The sampler, the command traces and the log write from threads of their
+ * own, which a fork() doesn't copy. This writes out what they have and
+ * closes their files so the parent's output is complete and the child
+ * doesn't inherit a half-written buffer; the child starts its own in
+ * redirectVisFile(). A recording is stopped as well: it only replays from
+ * cycle 0, so it ends where the children branch off.
+ */
+void MultiChannelMemorySystem::prepareFork()
+{
+	stopRecording();
+	delete sampler;
+	sampler = NULL;
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		channels[i]->stopCommandTrace();
+	}
+#ifdef LOG_OUTPUT
+	dramsim_log.flush();
+	logBuffer.close();
+#endif
+}
+
+/*
+ * The whole-run stats printed at the end only count what's simulated from
+ * here on, e.g. in a sweep variant that was warmed up under the base
+ * configuration. The current epoch's stats are left to finish their epoch.
+ */
+void MultiChannelMemorySystem::resetRunStats()
+{
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		channels[i]->resetRunStats();
+	}
+}
+
+void MultiChannelMemorySystem::saveState(CheckpointWriter &checkpoint) const
+{
+	if (analyticalModel)
+	{
+		ERROR("The analytical model (or its calibration) can't be checkpointed");
+		exit(-1);
+	}
+	checkpoint.writeSection(CHECKPOINT_MULTI_CHANNEL);
+	checkpoint.write(currentClockCycle);
+	checkpoint.write(clockDomainCrosser.clock1);
+	checkpoint.write(clockDomainCrosser.clock2);
+	checkpoint.write(clockDomainCrosser.counter1);
+	checkpoint.write(clockDomainCrosser.counter2);
+	checkpoint.write(clockDomainCrosser.ticks);
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		channels[i]->saveState(checkpoint);
+	}
+}
+
+void MultiChannelMemorySystem::restoreState(CheckpointReader &checkpoint)
+{
+	uint64_t savedClockCycle;
+	checkpoint.readSection(CHECKPOINT_MULTI_CHANNEL);
+	checkpoint.read(savedClockCycle);
+	// the output files are normally opened on the first cycle, which a
+	// restored memory system won't go through
+	if (currentClockCycle == 0 && savedClockCycle != 0)
+	{
+		InitOutputFiles(traceFilename);
+	}
+	currentClockCycle = savedClockCycle;
+	checkpoint.read(clockDomainCrosser.clock1);
+	checkpoint.read(clockDomainCrosser.clock2);
+	checkpoint.read(clockDomainCrosser.counter1);
+	checkpoint.read(clockDomainCrosser.counter2);
+	checkpoint.read(clockDomainCrosser.ticks);
+	if (recorder)
+	{
+		recorder->setClocks(clockDomainCrosser.clock1, clockDomainCrosser.clock2);
+	}
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		channels[i]->restoreState(checkpoint);
+	}
 }
 
 bool fileExists(string &path)
@@ -180,8 +361,8 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 
 
 	// create a properly named verification output file if need be and open it
-	// as the stream 'cmd_verify_out'
-	if (VERIFICATION_OUTPUT)
+	// as the stream 'cmd_verify_out' (once; a redirected vis file keeps it)
+	if (VERIFICATION_OUTPUT && !cmd_verify_out.is_open())
 	{
 		string basefilename = deviceIniFilename.substr(deviceIniFilename.find_last_of("/")+1);
 		string verify_filename =  "sim_out_"+basefilename;
@@ -197,6 +378,28 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 			abort(); 
 		}
 	}
+	// the command traces, and the samples when there is no vis file to put
+	// them next to, are named after the vis file when it has been given a name
+	// so that sweep variants and grid jobs each get their own
+	string basefilename = deviceIniFilename.substr(deviceIniFilename.find_last_of("/")+1);
+	string output_filename = visFilename ? *visFilename : "sim_out_"+basefilename;
+	if (sim_description != NULL)
+	{
+		output_filename += "."+sim_description_str;
+	}
+	// the same commands in binary, one file per channel
+	if (COMMAND_TRACE_OUTPUT)
+	{
+		for (size_t i=0; i<NUM_CHANS; i++)
+		{
+			if (isSimulated(i))
+			{
+				stringstream channelTraceFilename;
+				channelTraceFilename << output_filename << ".ch" << i << ".cmdtrace";
+				channels[i]->startCommandTrace(channelTraceFilename.str());
+			}
+		}
+	}
 	// This sets up the vis file output along with the creating the result
 	// directory structure if it doesn't exist
 	if (VIS_FILE_OUTPUT)
@@ -286,10 +489,33 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 		//write out the ini config values for the visualizer tool
 		IniReader::WriteValuesOut(visDataOut);
 
+		if (VIS_FILE_BINARY)
+		{
+			string binaryPath = path + "b";
+			visBinaryOut.open(binaryPath.c_str(), ios::out | ios::binary);
+			if (!visBinaryOut)
+			{
+				ERROR("Cannot open '"<<binaryPath<<"'");
+				exit(-1);
+			}
+			csvOut->setBinaryOutput(&visBinaryOut);
+		}
+
+		if (SAMPLE_INTERVAL > 0)
+		{
+			delete sampler;
+			sampler = new Sampler(path + ".samples");
+		}
+
 	}
 	else
 	{
 		// cerr << "vis file output disabled\n";
+		if (SAMPLE_INTERVAL > 0)
+		{
+			delete sampler;
+			sampler = new Sampler(output_filename + ".samples");
+		}
 	}
 #ifdef LOG_OUTPUT
 	string dramsimLogFilename(LOG_FILE);
@@ -300,9 +526,18 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
 	
 	dramsimLogFilename = FilenameWithNumberSuffix(dramsimLogFilename, ".log"); 
 
-	dramsim_log.open(dramsimLogFilename.c_str(), ios_base::out | ios_base::trunc );
+	// the log is written by a background thread; DRAMSIM_LOG_BUFFER_MB caps
+	// how much may wait for it (16MB by default) and with DRAMSIM_LOG_DROP
+	// set, records that don't fit are dropped instead of waited on
+	size_t logBufferMB = 16;
+	char *logBufferEnv = getenv("DRAMSIM_LOG_BUFFER_MB");
+	if (logBufferEnv)
+	{
+		logBufferMB = strtoul(logBufferEnv, NULL, 10);
+	}
+	AsyncLogBuffer::FullPolicy logPolicy = getenv("DRAMSIM_LOG_DROP") ? AsyncLogBuffer::Drop : AsyncLogBuffer::Block;
 
-	if (!dramsim_log) 
+	if (!logBuffer.open(dramsimLogFilename, logBufferMB*1024*1024, logPolicy))
 	{
 	ERROR("Cannot open "<< dramsimLogFilename);
 	//	exit(-1); 
@@ -350,6 +585,10 @@ void MultiChannelMemorySystem::mkdirIfNotExist(string path)
 
 MultiChannelMemorySystem::~MultiChannelMemorySystem()
 {
+	stopRecording();
+	delete analyticalModel;
+	delete calibrationReadDone;
+	delete calibrationWriteDone;
 	for (size_t i=0; i<NUM_CHANS; i++)
 	{
 		delete channels[i];
@@ -359,13 +598,16 @@ MultiChannelMemorySystem::~MultiChannelMemorySystem()
 // flush our streams and close them up
 #ifdef LOG_OUTPUT
 	dramsim_log.flush();
-	dramsim_log.close();
+	logBuffer.close();
 #endif
 	if (VIS_FILE_OUTPUT) 
 	{	
 		visDataOut.flush();
 		visDataOut.close();
+		visBinaryOut.close();
 	}
+	delete csvOut;
+	delete sampler;
 }
 void MultiChannelMemorySystem::update()
 {
@@ -373,25 +615,58 @@ void MultiChannelMemorySystem::update()
 }
 void MultiChannelMemorySystem::actual_update() 
 {
+	Profiler::nextCycle();
 	if (currentClockCycle == 0)
 	{
 		InitOutputFiles(traceFilename);
 		DEBUG("DRAMSim2 Clock Frequency ="<<clockDomainCrosser.clock1<<"Hz, CPU Clock Frequency="<<clockDomainCrosser.clock2<<"Hz"); 
 	}
 
+	if (analyticalEngine)
+	{
+		analyticalModel->update(currentClockCycle, readDone, writeDone);
+		currentClockCycle++;
+		return;
+	}
+
 	if (currentClockCycle % EPOCH_LENGTH == 0)
 	{
-		(*csvOut) << "ms" <<currentClockCycle * tCK * 1E-6; 
+		if (VIS_FILE_OUTPUT)
+		{
+			(*csvOut) << "ms" <<currentClockCycle * tCK * 1E-6; 
+		}
 		for (size_t i=0; i<NUM_CHANS; i++)
 		{
-			channels[i]->printStats(false); 
+			if (isSimulated(i))
+			{
+				channels[i]->printStats(false); 
+			}
+		}
+		if (VIS_FILE_OUTPUT)
+		{
+			csvOut->finalize();
+		}
+	}
+
+	if (sampler && currentClockCycle % SAMPLE_INTERVAL == 0)
+	{
+		Sample sample;
+		for (size_t i=0; i<NUM_CHANS; i++)
+		{
+			if (isSimulated(i))
+			{
+				channels[i]->memoryController->takeSample(sample);
+				sampler->add(sample);
+			}
 		}
-		csvOut->finalize();
 	}
 	
 	for (size_t i=0; i<NUM_CHANS; i++)
 	{
-		channels[i]->update(); 
+		if (isSimulated(i))
+		{
+			channels[i]->update(); 
+		}
 	}
 
 
@@ -420,6 +695,11 @@ unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
 		ERROR("Got channel index "<<channelNumber<<" but only "<<NUM_CHANS<<" exist"); 
 		abort();
 	}
+	if (!isSimulated(channelNumber))
+	{
+		ERROR("Address 0x"<<hex<<addr<<dec<<" maps to channel "<<channelNumber<<" but only channel "<<onlyChannel<<" is being simulated; split the trace with --split-trace first"); 
+		abort();
+	}
 	//DEBUG("Channel idx = "<<channelNumber<<" totalbits="<<totalBits<<" channelbits="<<channelBits); 
 
 	return channelNumber;
@@ -438,13 +718,56 @@ bool MultiChannelMemorySystem::addTransaction(const Transaction &trans)
 bool MultiChannelMemorySystem::addTransaction(Transaction *trans)
 {
 	unsigned channelNumber = findChannelNumber(trans->address); 
-	return channels[channelNumber]->addTransaction(trans); 
+	// the channel owns trans once it's accepted
+	bool isWrite = (trans->transactionType == DATA_WRITE);
+	uint64_t addr = trans->address;
+	bool accepted;
+	if (analyticalEngine)
+	{
+		accepted = analyticalModel->willAcceptTransaction(addr);
+		if (accepted)
+		{
+			analyticalModel->addTransaction(isWrite, addr, currentClockCycle);
+			delete trans;
+		}
+	}
+	else
+	{
+		accepted = channels[channelNumber]->addTransaction(trans); 
+		if (accepted && analyticalModel)
+		{
+			analyticalModel->observe(isWrite, addr, currentClockCycle);
+		}
+	}
+	if (accepted && recorder)
+	{
+		recorder->record(clockDomainCrosser.ticks, isWrite, addr, false);
+	}
+	return accepted;
 }
 
 bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr)
 {
 	unsigned channelNumber = findChannelNumber(addr); 
-	return channels[channelNumber]->addTransaction(isWrite, addr); 
+	bool accepted;
+	if (analyticalEngine)
+	{
+		analyticalModel->addTransaction(isWrite, addr, currentClockCycle, true);
+		accepted = true;
+	}
+	else
+	{
+		accepted = channels[channelNumber]->addTransaction(isWrite, addr); 
+		if (accepted && analyticalModel)
+		{
+			analyticalModel->observe(isWrite, addr, currentClockCycle);
+		}
+	}
+	if (accepted && recorder)
+	{
+		recorder->record(clockDomainCrosser.ticks, isWrite, addr, true);
+	}
+	return accepted;
 }
 
 /*
@@ -458,6 +781,10 @@ bool MultiChannelMemorySystem::addTransaction(bool isWrite, uint64_t addr)
 
 bool MultiChannelMemorySystem::willAcceptTransaction(uint64_t addr)
 {
+	if (analyticalEngine)
+	{
+		return analyticalModel->willAcceptTransaction(addr);
+	}
 	unsigned chan, rank,bank,row,col; 
 	addressMapping(addr, chan, rank, bank, row, col); 
 	return channels[chan]->WillAcceptTransaction(); 
@@ -465,6 +792,10 @@ bool MultiChannelMemorySystem::willAcceptTransaction(uint64_t addr)
 
 bool MultiChannelMemorySystem::willAcceptTransaction()
 {
+	if (analyticalEngine)
+	{
+		return analyticalModel->willAcceptTransaction();
+	}
 	for (size_t c=0; c<NUM_CHANS; c++) {
 		if (!channels[c]->WillAcceptTransaction())
 		{
@@ -474,28 +805,223 @@ bool MultiChannelMemorySystem::willAcceptTransaction()
 	return true; 
 }
 
+/*
+ * Functional fast-forward: jumps cycles ahead without simulating them, with
+ * functionalAccess() standing in for the requests that fall in the gap. Only
+ * the state that outlasts the gap is kept up to date -- which rows are open
+ * and where each rank is in its refresh period -- so nothing may be in flight
+ * and none of it shows up in the stats. The clocks have to run 1:1 since the
+ * gap is counted in memory cycles.
+ */
+void MultiChannelMemorySystem::fastForward(uint64_t cycles)
+{
+	if (clockDomainCrosser.clock1 != clockDomainCrosser.clock2)
+	{
+		ERROR("Fast-forward needs the CPU and memory clocks to run 1:1");
+		exit(-1);
+	}
+	if (!isDrained())
+	{
+		ERROR("Can't fast-forward with requests in flight");
+		exit(-1);
+	}
+	if (cycles == 0)
+	{
+		return;
+	}
+	if (currentClockCycle == 0)
+	{
+		InitOutputFiles(traceFilename);
+	}
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		channels[i]->fastForward(cycles);
+	}
+	clockDomainCrosser.ticks += cycles;
+	currentClockCycle += cycles;
+}
+
+void MultiChannelMemorySystem::functionalAccess(uint64_t addr)
+{
+	channels[findChannelNumber(addr)]->functionalAccess(addr);
+}
+
+/*
+ * True once nothing that was added is still in flight anywhere: transaction
+ * and command queues empty, no reads waiting for data and no write data
+ * left to send, on every channel.
+ */
+bool MultiChannelMemorySystem::isDrained() const
+{
+	if (analyticalEngine)
+	{
+		return analyticalModel->isDrained();
+	}
+	for (size_t c=0; c<NUM_CHANS; c++)
+	{
+		if (!channels[c]->isDrained())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 
 
 void MultiChannelMemorySystem::printStats(bool finalStats) {
 
-	(*csvOut) << "ms" <<currentClockCycle * tCK * 1E-6; 
+	if (analyticalEngine)
+	{
+		stringstream stats;
+		analyticalModel->printStats(stats, currentClockCycle);
+		PRINTN(stats.str());
+		return;
+	}
+	if (VIS_FILE_OUTPUT)
+	{
+		(*csvOut) << "ms" <<currentClockCycle * tCK * 1E-6; 
+	}
 	for (size_t i=0; i<NUM_CHANS; i++)
 	{
+		if (!isSimulated(i))
+		{
+			continue;
+		}
 		PRINT("==== Channel ["<<i<<"] ====");
 		channels[i]->printStats(finalStats); 
 		PRINT("//// Channel ["<<i<<"] ////");
 	}
-	csvOut->finalize();
+	if (VIS_FILE_OUTPUT)
+	{
+		csvOut->finalize();
+	}
 }
 void MultiChannelMemorySystem::RegisterCallbacks( 
 		TransactionCompleteCB *readDone,
 		TransactionCompleteCB *writeDone,
 		void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower))
 {
+	this->readDone = readDone;
+	this->writeDone = writeDone;
+	this->reportPower = reportPower;
+	installCallbacks();
+}
+
+// while calibrating the completions go through the model on their way to the caller
+void MultiChannelMemorySystem::installCallbacks()
+{
+	bool calibrating = analyticalModel && !analyticalEngine;
 	for (size_t i=0; i<NUM_CHANS; i++)
 	{
-		channels[i]->RegisterCallbacks(readDone, writeDone, reportPower); 
+		channels[i]->RegisterCallbacks(calibrating ? calibrationReadDone : readDone,
+				calibrating ? calibrationWriteDone : writeDone, reportPower); 
+	}
+}
+
+void MultiChannelMemorySystem::calibrationReadComplete(unsigned id, uint64_t addr, uint64_t cycle)
+{
+	analyticalModel->observeCompletion(false, addr, cycle);
+	if (readDone)
+	{
+		(*readDone)(id, addr, cycle);
+	}
+}
+
+void MultiChannelMemorySystem::calibrationWriteComplete(unsigned id, uint64_t addr, uint64_t cycle)
+{
+	analyticalModel->observeCompletion(true, addr, cycle);
+	if (writeDone)
+	{
+		(*writeDone)(id, addr, cycle);
+	}
+}
+
+/*
+ * Channel sharding: a run that is fed only the requests of one channel (as
+ * split off by --split-trace) updates and reports just that channel, so that
+ * running one process per channel and merging their output (see
+ * shard_sim.py) stands in for a run of the whole system. With open loop
+ * replay the channels only interact through the shared trace cursor (a
+ * request that has to wait, for a full queue or behind another request due
+ * the same cycle, holds up the ones after it), so the results are close but
+ * not identical. Requests for any other channel are an error.
+ */
+void MultiChannelMemorySystem::simulateOnlyChannel(unsigned channel)
+{
+	if (channel >= NUM_CHANS)
+	{
+		ERROR("Can't simulate channel "<<channel<<" of a "<<NUM_CHANS<<" channel system");
+		exit(-1);
+	}
+	singleChannel = true;
+	onlyChannel = channel;
+}
+
+bool MultiChannelMemorySystem::isSimulated(unsigned channel) const
+{
+	return !singleChannel || channel == onlyChannel;
+}
+
+/*
+ * Switches to the analytical engine: from here on requests are timed by
+ * AnalyticalModel (with the coefficients from a --calibrate run, if given)
+ * and the channels sit idle. Meant to be called before the first request.
+ */
+void MultiChannelMemorySystem::useAnalyticalModel(const string &coefficientsFilename)
+{
+	if (!isDrained())
+	{
+		ERROR("Can't switch to the analytical model with requests in flight");
+		exit(-1);
+	}
+	delete analyticalModel;
+	analyticalModel = new AnalyticalModel();
+	if (coefficientsFilename.length() > 0 && !analyticalModel->loadCoefficients(coefficientsFilename))
+	{
+		exit(-1);
+	}
+	analyticalEngine = true;
+	installCallbacks();
+	DEBUG("== Using the analytical model"<<(coefficientsFilename.length() > 0 ? " with coefficients from '"+coefficientsFilename+"'" : "")<<" == ");
+}
+
+/*
+ * Calibration: the detailed model keeps running as usual while an
+ * AnalyticalModel watches every request go in and come back;
+ * finishCalibration() fits the model to what it saw, reports how far off
+ * it is and saves the coefficients for useAnalyticalModel().
+ */
+void MultiChannelMemorySystem::startCalibration()
+{
+	delete analyticalModel;
+	analyticalModel = new AnalyticalModel();
+	analyticalEngine = false;
+	if (!calibrationReadDone)
+	{
+		calibrationReadDone = new Callback<MultiChannelMemorySystem, void, unsigned, uint64_t, uint64_t>(this, &MultiChannelMemorySystem::calibrationReadComplete);
+		calibrationWriteDone = new Callback<MultiChannelMemorySystem, void, unsigned, uint64_t, uint64_t>(this, &MultiChannelMemorySystem::calibrationWriteComplete);
+	}
+	installCallbacks();
+}
+
+bool MultiChannelMemorySystem::finishCalibration(const string &coefficientsFilename)
+{
+	if (!analyticalModel || analyticalEngine)
+	{
+		ERROR("finishCalibration() without startCalibration()");
+		return false;
+	}
+	bool fitted = analyticalModel->calibrate(cout);
+	if (fitted)
+	{
+		analyticalModel->saveCoefficients(coefficientsFilename);
+		cout << "== Wrote analytical model coefficients to '"<<coefficientsFilename<<"' =="<<endl;
 	}
+	delete analyticalModel;
+	analyticalModel = NULL;
+	installCallbacks();
+	return fitted;
 }
 namespace DRAMSim {
 MultiChannelMemorySystem *getMemorySystemInstance(const string &dev, const string &sys, const string &pwd, const string &trc, unsigned megsOfMemory, string *visfilename) 
@@ -27,6 +27,9 @@
 *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *********************************************************************************/
+#ifndef MULTICHANNELMEMORYSYSTEM_H
+#define MULTICHANNELMEMORYSYSTEM_H
+
 #include "SimulatorObject.h"
 #include "Transaction.h"
 #include "SystemConfiguration.h"
@@ -34,10 +37,16 @@
 #include "IniReader.h"
 #include "ClockDomain.h"
 #include "CSVWriter.h"
+#include "AsyncLog.h"
 
 
 namespace DRAMSim {
 
+class RequestRecorder;
+class AnalyticalModel;
+class CheckpointWriter;
+class CheckpointReader;
+class Sampler;
 
 class MultiChannelMemorySystem : public SimulatorObject 
 {
@@ -50,6 +59,9 @@ class MultiChannelMemorySystem : public SimulatorObject
 			bool addTransaction(bool isWrite, uint64_t addr);
 			bool willAcceptTransaction(); 
 			bool willAcceptTransaction(uint64_t addr); 
+			bool isDrained() const;
+			void fastForward(uint64_t cycles);
+			void functionalAccess(uint64_t addr);
 			void update();
 			void printStats(bool finalStats=false);
 			ostream &getLogFile();
@@ -60,14 +72,33 @@ class MultiChannelMemorySystem : public SimulatorObject
 
 	void InitOutputFiles(string tracefilename);
 	void setCPUClockSpeed(uint64_t cpuClkFreqHz);
+	void startRecording(const string &filename);
+	void stopRecording();
+	void saveCheckpoint(const string &filename) const;
+	void restoreCheckpoint(const string &filename);
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
+	void redirectVisFile(string *visFilename);
+	void prepareFork();
+	void resetRunStats();
+	void useAnalyticalModel(const string &coefficientsFilename="");
+	void startCalibration();
+	bool finishCalibration(const string &coefficientsFilename);
+	void simulateOnlyChannel(unsigned channel);
 
 	//output file
 	std::ofstream visDataOut;
-	ofstream dramsim_log; 
+	std::ofstream visBinaryOut;
+	// dramsim_log writes through logBuffer, which is only opened with LOG_OUTPUT
+	AsyncLogBuffer logBuffer;
+	ostream dramsim_log; 
 
 	private:
 		unsigned findChannelNumber(uint64_t addr);
 		void actual_update(); 
+		void installCallbacks();
+		void calibrationReadComplete(unsigned id, uint64_t addr, uint64_t cycle);
+		void calibrationWriteComplete(unsigned id, uint64_t addr, uint64_t cycle);
 		vector<MemorySystem*> channels; 
 		unsigned megsOfMemory; 
 		string deviceIniFilename;
@@ -79,7 +110,26 @@ class MultiChannelMemorySystem : public SimulatorObject
 		static void mkdirIfNotExist(string path);
 		static bool fileExists(string path); 
 		CSVWriter *csvOut; 
+		// the SAMPLE_INTERVAL time series (NULL when off)
+		Sampler *sampler;
+		// logs every accepted request for DRAM-only replay (NULL when off)
+		RequestRecorder *recorder;
+		// stands in for the channels when analyticalEngine is set and
+		// otherwise, while calibrating, watches what they do (NULL when off)
+		AnalyticalModel *analyticalModel;
+		bool analyticalEngine;
+		TransactionCompleteCB *readDone;
+		TransactionCompleteCB *writeDone;
+		void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower);
+		TransactionCompleteCB *calibrationReadDone;
+		TransactionCompleteCB *calibrationWriteDone;
+		// when set, only onlyChannel is updated and reported (see simulateOnlyChannel())
+		bool singleChannel;
+		unsigned onlyChannel;
+		bool isSimulated(unsigned channel) const;
 
 
 	};
 }
+
+#endif
@@ -0,0 +1,177 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//Profiler.cpp
+//
+//Progress reports and the end of run summary of the simulator's profile
+//
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <sys/resource.h>
+#include "Profiler.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+bool Profiler::enabled = false;
+uint64_t Profiler::phaseTime[NUM_PROFILE_PHASES];
+uint64_t Profiler::phaseCalls[NUM_PROFILE_PHASES];
+uint64_t Profiler::startTime = 0;
+uint64_t Profiler::startCycle = 0;
+uint64_t Profiler::startRequests = 0;
+uint64_t Profiler::totalCycles = 0;
+double Profiler::interval = 0.0;
+uint64_t Profiler::lastReportTime = 0;
+uint64_t Profiler::lastReportCycle = 0;
+uint64_t Profiler::lastReportRequests = 0;
+bool Profiler::timingCycle = false;
+uint32_t Profiler::random = 1;
+uint64_t Profiler::cycles = 0;
+uint64_t Profiler::timedCycles = 0;
+double Profiler::clockOverhead = 0.0;
+
+#ifndef DRAMSIM_RELEASE
+static const char *phaseNames[NUM_PROFILE_PHASES] =
+{
+	"bank states",
+	"refresh",
+	"command queue pop",
+	"transaction decode",
+	"power",
+	"rank update",
+	"stats",
+	"trace parsing"
+};
+#endif
+
+//totalCycles_ is what the run will end on, 0 when that isn't known (no ETA then);
+//	startCycle_ and startRequests_ are where a restored or fast-forwarded run starts from
+void Profiler::start(double interval_, uint64_t totalCycles_, uint64_t startCycle_, uint64_t startRequests_)
+{
+	for (size_t i=0; i<NUM_PROFILE_PHASES; i++)
+	{
+		phaseTime[i] = 0;
+		phaseCalls[i] = 0;
+	}
+	interval = interval_;
+	totalCycles = totalCycles_;
+	startCycle = lastReportCycle = startCycle_;
+	startRequests = lastReportRequests = startRequests_;
+	cycles = timedCycles = 0;
+	// reading the clock costs the same every time, so the average of a few
+	//	thousand empty scopes is a good estimate of it
+	static const unsigned CALIBRATION_SCOPES = 10000;
+	uint64_t calibrationStart = now();
+	for (size_t i=0; i<CALIBRATION_SCOPES; i++)
+	{
+		now();
+	}
+	clockOverhead = (double)(now() - calibrationStart) / CALIBRATION_SCOPES;
+	startTime = lastReportTime = now();
+	enabled = true;
+}
+
+void Profiler::progress(uint64_t cycle, uint64_t requests)
+{
+	uint64_t time = now();
+	double seconds = (time - lastReportTime) * 1E-9;
+	if (seconds < interval)
+	{
+		return;
+	}
+	double cyclesPerSecond = (cycle - lastReportCycle) / seconds;
+	ios::fmtflags flags = cerr.flags();
+	streamsize precision = cerr.precision();
+	cerr << "== Profile: cycle " << cycle;
+	if (totalCycles > cycle)
+	{
+		cerr << " of " << totalCycles << " (" << fixed << setprecision(1) << 100.0 * cycle / totalCycles << "%)";
+	}
+	cerr << fixed << setprecision(0) << ", " << cyclesPerSecond << " cycles/s, "
+		<< (requests - lastReportRequests) / seconds << " requests/s";
+	if (totalCycles > cycle && cyclesPerSecond > 0)
+	{
+		unsigned eta = (unsigned)((totalCycles - cycle) / cyclesPerSecond);
+		cerr << ", ETA " << eta / 3600 << ":" << setfill('0') << setw(2) << (eta / 60) % 60 << ":" << setw(2) << eta % 60 << setfill(' ');
+	}
+	cerr << ", peak RSS " << peakResidentKB() / 1024 << " MB ==" << endl;
+	cerr.flags(flags);
+	cerr.precision(precision);
+	lastReportTime = time;
+	lastReportCycle = cycle;
+	lastReportRequests = requests;
+}
+
+void Profiler::printSummary(ostream &out, uint64_t cycle, uint64_t requests)
+{
+	double seconds = (now() - startTime) * 1E-9;
+	uint64_t simulatedCycles = cycle - startCycle;
+	requests -= startRequests;
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	out << "== Profile: " << simulatedCycles << " cycles and " << requests << " requests in " << fixed << setprecision(2) << seconds << " s ==" << endl;
+	out << setprecision(0) << "   " << (seconds > 0 ? simulatedCycles / seconds : 0.0) << " cycles/s, "
+		<< (seconds > 0 ? requests / seconds : 0.0) << " requests/s, peak RSS " << peakResidentKB() / 1024 << " MB" << endl;
+#ifdef DRAMSIM_RELEASE
+	out << "   (the phase timers are compiled out of the release build)" << endl;
+#else
+	// the per-cycle phases were timed on timedCycles of the cycles
+	double scale = (timedCycles > 0) ? (double)cycles / timedCycles : 0.0;
+	double other = seconds;
+	out << "   " << left << setw(20) << "phase" << right << setw(10) << "seconds" << setw(8) << "%" << setw(14) << "calls" << setw(10) << "ns/call" << endl;
+	for (size_t i=0; i<NUM_PROFILE_PHASES; i++)
+	{
+		double phaseScale = (i < PROFILE_STATS) ? scale : 1.0;
+		double measured = max(0.0, phaseTime[i] - phaseCalls[i] * clockOverhead);
+		double phaseSeconds = measured * 1E-9 * phaseScale;
+		other -= phaseSeconds;
+		out << "   " << left << setw(20) << phaseNames[i] << right << setprecision(3) << setw(10) << phaseSeconds
+			<< setprecision(1) << setw(8) << (seconds > 0 ? 100.0 * phaseSeconds / seconds : 0.0)
+			<< setprecision(0) << setw(14) << phaseCalls[i] * phaseScale
+			<< setprecision(0) << setw(10) << (phaseCalls[i] > 0 ? measured / phaseCalls[i] : 0.0) << endl;
+	}
+	out << "   " << left << setw(20) << "other" << right << setprecision(3) << setw(10) << other
+		<< setprecision(1) << setw(8) << (seconds > 0 ? 100.0 * other / seconds : 0.0) << endl;
+#endif
+	out.flags(flags);
+	out.precision(precision);
+}
+
+//the high water mark of the resident set size so far
+long Profiler::peakResidentKB()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+}
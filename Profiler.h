@@ -0,0 +1,165 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+//Profiler.h
+//
+//Header file for the simulator's own wall clock profile
+//
+
+#include <ostream>
+#include <stdint.h>
+#include <time.h>
+
+namespace DRAMSim
+{
+// the parts of a simulated cycle that get their own timer
+enum ProfilePhase
+{
+	PROFILE_BANK_STATES,
+	PROFILE_REFRESH,
+	PROFILE_COMMAND_QUEUE_POP,
+	PROFILE_TRANSACTION_DECODE,
+	PROFILE_POWER,
+	PROFILE_RANK_UPDATE,
+	// the phases from here on don't run every cycle and are timed every time
+	PROFILE_STATS,
+	PROFILE_TRACE_PARSING,
+	NUM_PROFILE_PHASES
+};
+
+/*
+ * Where the simulator spends its time. Once start() is called a
+ * PROFILE_SCOPE adds the time until the end of its block to its phase;
+ * before that a scope costs a test of two globals. progress() prints the
+ * simulation speed and an ETA every interval seconds and printSummary() the
+ * time per phase, the speed and the peak resident set size at the end.
+ *
+ * The per-cycle phases run millions of times a second and reading the clock
+ * around every one of them would triple the run time, so they are only
+ * timed on a random one in SAMPLE_PERIOD cycles (see nextCycle()) and scaled
+ * up in the summary. Random rather than every SAMPLE_PERIOD-th cycle so that
+ * nothing periodic, like refresh, is always or never in the sample.
+ *
+ * The phases don't nest, so whatever isn't in any of them (the trace driver,
+ * clock domain crossing, the rest of the controller's update) shows up as
+ * "other". What a scope measures when its block is empty (the cost of
+ * reading the clock) is subtracted from every call.
+ */
+class Profiler
+{
+public:
+	static void start(double interval, uint64_t totalCycles, uint64_t startCycle, uint64_t startRequests);
+	static void progress(uint64_t cycle, uint64_t requests);
+	static void printSummary(std::ostream &out, uint64_t cycle, uint64_t requests);
+	static long peakResidentKB();
+
+	static uint64_t now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+	static void add(ProfilePhase phase, uint64_t ns)
+	{
+		phaseTime[phase] += ns;
+		phaseCalls[phase]++;
+	}
+	//called at the start of every memory cycle, picks the cycles that are timed
+	static void nextCycle()
+	{
+		if (enabled)
+		{
+			random = random * 1103515245 + 12345;
+			timingCycle = ((random >> 16) & (SAMPLE_PERIOD - 1)) == 0;
+			cycles++;
+			timedCycles += timingCycle;
+		}
+	}
+	static bool isTimed(ProfilePhase phase)
+	{
+		return timingCycle || (enabled && phase >= PROFILE_STATS);
+	}
+
+	static bool enabled;
+	static const unsigned SAMPLE_PERIOD = 16;
+
+	// progress() only looks at the clock when (cycle & PROGRESS_CHECK_MASK) == 0
+	static const uint64_t PROGRESS_CHECK_MASK = 0xFFFF;
+
+private:
+	static uint64_t phaseTime[NUM_PROFILE_PHASES];
+	static uint64_t phaseCalls[NUM_PROFILE_PHASES];
+	static uint64_t startTime;
+	static uint64_t startCycle;
+	static uint64_t startRequests;
+	static uint64_t totalCycles;
+	static double interval;
+	static uint64_t lastReportTime;
+	static uint64_t lastReportCycle;
+	static uint64_t lastReportRequests;
+	static bool timingCycle;
+	static uint32_t random;
+	static uint64_t cycles;
+	static uint64_t timedCycles;
+	// what a scope measures when there is nothing in it
+	static double clockOverhead;
+};
+
+class ProfileScope
+{
+public:
+	ProfileScope(ProfilePhase phase_) :
+		phase(phase_),
+		start(Profiler::isTimed(phase_) ? Profiler::now() : 0)
+	{}
+	~ProfileScope()
+	{
+		if (start != 0)
+		{
+			Profiler::add(phase, Profiler::now() - start);
+		}
+	}
+private:
+	ProfilePhase phase;
+	uint64_t start;
+};
+}
+
+// the release build leaves the phase timers out altogether
+#ifdef DRAMSIM_RELEASE
+#define PROFILE_SCOPE(phase)
+#else
+#define PROFILE_SCOPE(phase) DRAMSim::ProfileScope profileScope(phase)
+#endif
+
+#endif
@@ -33,6 +33,9 @@
 
 #include "Rank.h"
 #include "MemoryController.h"
+#include "Checkpoint.h"
+#include "CommandTrace.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace DRAMSim;
@@ -49,6 +52,7 @@ Rank::Rank(ostream &dramsim_log_) :
 {
 
 	memoryController = NULL;
+	commandTrace = NULL;
 	outgoingDataPacket = NULL;
 	dataCyclesLeft = 0;
 	currentClockCycle = 0;
@@ -90,6 +94,10 @@ void Rank::receiveFromBus(BusPacket *packet)
 	{
 		packet->print(currentClockCycle,false);
 	}
+	if (commandTrace)
+	{
+		commandTrace->add(currentClockCycle, packet);
+	}
 
 	switch (packet->busPacketType)
 	{
@@ -296,8 +304,15 @@ int Rank::getId() const
 	return this->id;
 }
 
+//no read data waiting to go back to the controller
+bool Rank::isDrained() const
+{
+	return readReturnPacket.empty() && outgoingDataPacket == NULL;
+}
+
 void Rank::update()
 {
+	PROFILE_SCOPE(PROFILE_RANK_UPDATE);
 
 	// An outgoing packet is one that is currently sending on the bus
 	// do the book keeping for the packet's time left on the bus
@@ -383,3 +398,56 @@ void Rank::powerUp()
 		bankStates[i].currentBankState = Idle;
 	}
 }
+
+void Rank::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_RANK);
+	checkpoint.write(currentClockCycle);
+	checkpoint.write(incomingWriteBank);
+	checkpoint.write(incomingWriteRow);
+	checkpoint.write(incomingWriteColumn);
+	checkpoint.write(isPowerDown);
+	checkpoint.write(refreshWaiting);
+	checkpoint.writePacket(outgoingDataPacket);
+	checkpoint.write(dataCyclesLeft);
+	checkpoint.write<uint64_t>(readReturnPacket.size());
+	for (size_t i=0; i<readReturnPacket.size(); i++)
+	{
+		checkpoint.writePacket(readReturnPacket[i]);
+	}
+	checkpoint.writeVector(readReturnCountdown);
+	for (size_t i=0; i<NUM_BANKS; i++)
+	{
+		bankStates[i].saveState(checkpoint);
+	}
+}
+
+void Rank::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readSection(CHECKPOINT_RANK);
+	checkpoint.read(currentClockCycle);
+	checkpoint.read(incomingWriteBank);
+	checkpoint.read(incomingWriteRow);
+	checkpoint.read(incomingWriteColumn);
+	checkpoint.read(isPowerDown);
+	checkpoint.read(refreshWaiting);
+	delete outgoingDataPacket;
+	outgoingDataPacket = checkpoint.readPacket(dramsim_log);
+	checkpoint.read(dataCyclesLeft);
+	for (size_t i=0; i<readReturnPacket.size(); i++)
+	{
+		delete readReturnPacket[i];
+	}
+	uint64_t size;
+	checkpoint.read(size);
+	readReturnPacket.resize(size);
+	for (size_t i=0; i<size; i++)
+	{
+		readReturnPacket[i] = checkpoint.readPacket(dramsim_log);
+	}
+	checkpoint.readVector(readReturnCountdown);
+	for (size_t i=0; i<NUM_BANKS; i++)
+	{
+		bankStates[i].restoreState(checkpoint);
+	}
+}
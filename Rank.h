@@ -46,6 +46,9 @@ using namespace DRAMSim;
 namespace DRAMSim
 {
 class MemoryController; //forward declaration
+class CommandTrace;
+class CheckpointWriter;
+class CheckpointReader;
 class Rank : public SimulatorObject
 {
 private:
@@ -67,9 +70,14 @@ public:
 	void update();
 	void powerUp();
 	void powerDown();
+	bool isDrained() const;
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
 
 	//fields
 	MemoryController *memoryController;
+	// every command received goes here when COMMAND_TRACE_OUTPUT is set (NULL otherwise)
+	CommandTrace *commandTrace;
 	BusPacket *outgoingDataPacket;
 	unsigned dataCyclesLeft;
 	bool refreshWaiting;
@@ -0,0 +1,218 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//RequestRecorder.cpp
+//
+//Class file for recording the requests made through the API and reading
+//them back for replay
+//
+
+#include "RequestRecorder.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+RequestRecorder::RequestRecorder(const string &filename_, uint64_t dramClockHz_, uint64_t cpuClockHz_) :
+	filename(filename_),
+	recordsWritten(0),
+	out(filename_.c_str(), ios::binary | ios::trunc),
+	headerWritten(false),
+	dramClockHz(dramClockHz_),
+	cpuClockHz(cpuClockHz_),
+	lastCycle(0),
+	lastAddress(0)
+{
+	if (!out.is_open())
+	{
+		ERROR("Could not open request recording '"<<filename<<"' for writing");
+		exit(-1);
+	}
+}
+
+RequestRecorder::~RequestRecorder()
+{
+	if (!headerWritten)
+	{
+		writeHeader();
+	}
+	out.close();
+}
+
+//the header isn't written until the first request so that the host has a
+//chance to set the CPU clock after creating the memory system
+void RequestRecorder::setClocks(uint64_t dramClockHz_, uint64_t cpuClockHz_)
+{
+	dramClockHz = dramClockHz_;
+	cpuClockHz = cpuClockHz_;
+}
+
+void RequestRecorder::writeHeader()
+{
+	uint32_t magic = MAGIC, version = VERSION;
+	out.write((const char *)&magic, sizeof(magic));
+	out.write((const char *)&version, sizeof(version));
+	out.write((const char *)&dramClockHz, sizeof(dramClockHz));
+	out.write((const char *)&cpuClockHz, sizeof(cpuClockHz));
+	headerWritten = true;
+}
+
+void RequestRecorder::writeVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.put((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.put((char)value);
+}
+
+void RequestRecorder::record(uint64_t cpuCycle, bool isWrite, uint64_t address, bool queueIfFull)
+{
+	if (!headerWritten)
+	{
+		writeHeader();
+	}
+
+	uint64_t delta = address - lastAddress;
+	// zigzag so that small negative strides stay small
+	uint64_t zigzag = (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+
+	writeVarint(((cpuCycle - lastCycle) << 2) | (queueIfFull ? 2 : 0) | (isWrite ? 1 : 0));
+	writeVarint(zigzag);
+
+	lastCycle = cpuCycle;
+	lastAddress = address;
+	recordsWritten++;
+}
+
+RequestReplayReader::RequestReplayReader(const string &filename_) :
+	filename(filename_),
+	dramClockHz(0),
+	cpuClockHz(0),
+	in(filename_.c_str(), ios::binary),
+	lastCycle(0),
+	lastAddress(0),
+	forkPosition(0),
+	forkAtEnd(false)
+{
+	if (!in.is_open())
+	{
+		ERROR("Could not open request recording '"<<filename<<"'");
+		exit(-1);
+	}
+
+	uint32_t magic=0, version=0;
+	in.read((char *)&magic, sizeof(magic));
+	in.read((char *)&version, sizeof(version));
+	in.read((char *)&dramClockHz, sizeof(dramClockHz));
+	in.read((char *)&cpuClockHz, sizeof(cpuClockHz));
+	if (!in || magic != RequestRecorder::MAGIC)
+	{
+		ERROR("'"<<filename<<"' is not a request recording");
+		exit(-1);
+	}
+	if (version != RequestRecorder::VERSION)
+	{
+		ERROR("Request recording '"<<filename<<"' is version "<<version<<", expected "<<RequestRecorder::VERSION);
+		exit(-1);
+	}
+}
+
+bool RequestReplayReader::readVarint(uint64_t &value)
+{
+	value = 0;
+	for (unsigned shift=0; shift<64; shift+=7)
+	{
+		int c = in.get();
+		if (c == EOF)
+		{
+			return false;
+		}
+		value |= (uint64_t)(c & 0x7F) << shift;
+		if ((c & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	ERROR("Corrupt varint in request recording");
+	exit(-1);
+}
+
+bool RequestReplayReader::next(TraceRecord &record)
+{
+	uint64_t header, zigzag;
+	if (!readVarint(header))
+	{
+		return false;
+	}
+	if (!readVarint(zigzag))
+	{
+		ERROR("Request recording is truncated");
+		return false;
+	}
+
+	lastCycle += header >> 2;
+	lastAddress += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+
+	record.clockCycle = lastCycle;
+	record.address = lastAddress;
+	record.transactionType = (header & 1) ? DATA_WRITE : DATA_READ;
+	record.queueIfFull = (header & 2) != 0;
+	record.data = NULL;
+	return true;
+}
+
+void RequestReplayReader::prepareFork()
+{
+	forkAtEnd = in.eof();
+	forkPosition = forkAtEnd ? std::streampos(0) : in.tellg();
+}
+
+void RequestReplayReader::reopenAfterFork()
+{
+	in.close();
+	in.clear();
+	in.open(filename.c_str(), ios::binary);
+	if (!in.is_open())
+	{
+		ERROR("Could not reopen request recording '"<<filename<<"'");
+		exit(-1);
+	}
+	if (forkAtEnd)
+	{
+		in.seekg(0, ios::end);
+	}
+	else
+	{
+		in.seekg(forkPosition);
+	}
+}
@@ -0,0 +1,116 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef REQUESTRECORDER_H
+#define REQUESTRECORDER_H
+
+//RequestRecorder.h
+//
+//Header file for recording the requests made through the API and reading
+//them back for replay
+//
+
+#include <fstream>
+#include <string>
+#include "TraceReader.h"
+
+using std::string;
+
+namespace DRAMSim
+{
+/*
+ * Recording file format: a header
+ *
+ *   uint32_t magic, uint32_t version, uint64_t dram clock Hz, uint64_t cpu clock Hz
+ *
+ * followed by one record per accepted addTransaction() call, each made of
+ * two LEB128 varints:
+ *
+ *   (cpu cycles since the previous request << 2) | (queueIfFull << 1) | isWrite
+ *   zigzag(address - previous address)
+ *
+ * Requests are mostly close in time and space so most records are 2-4 bytes.
+ */
+class RequestRecorder
+{
+public:
+	static const uint32_t MAGIC = 0x52525344; // "DSRR"
+	static const uint32_t VERSION = 1;
+
+	RequestRecorder(const string &filename, uint64_t dramClockHz, uint64_t cpuClockHz);
+	~RequestRecorder();
+	void setClocks(uint64_t dramClockHz, uint64_t cpuClockHz);
+	void record(uint64_t cpuCycle, bool isWrite, uint64_t address, bool queueIfFull);
+
+	const string filename;
+	uint64_t recordsWritten;
+
+private:
+	void writeHeader();
+	void writeVarint(uint64_t value);
+
+	std::ofstream out;
+	bool headerWritten;
+	uint64_t dramClockHz;
+	uint64_t cpuClockHz;
+	uint64_t lastCycle;
+	uint64_t lastAddress;
+};
+
+/*
+ * RequestReplayReader: reads a recording back as a TraceSource; clock
+ * cycles are the CPU cycles the requests were originally made on.
+ */
+class RequestReplayReader : public TraceSource
+{
+public:
+	RequestReplayReader(const string &filename);
+	bool next(TraceRecord &record);
+	void prepareFork();
+	void reopenAfterFork();
+
+	const string filename;
+
+	uint64_t dramClockHz;
+	uint64_t cpuClockHz;
+
+private:
+	bool readVarint(uint64_t &value);
+
+	std::ifstream in;
+	uint64_t lastCycle;
+	uint64_t lastAddress;
+	std::streampos forkPosition;
+	bool forkAtEnd;
+};
+}
+
+#endif
+
@@ -0,0 +1,101 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+//RingBuffer.h
+//
+//Fixed size queue between one producer thread and one consumer thread
+//
+
+#include <vector>
+#include <stdint.h>
+
+namespace DRAMSim
+{
+/*
+ * Single producer, single consumer ring of a power of two slots (one is
+ * always left empty). Only the producer moves head and only the consumer
+ * moves tail; the barriers make sure a slot is written before the producer
+ * publishes it and read before the consumer hands it back. Neither side
+ * ever waits: push() fails when the ring is full, pop() when it is empty.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+	RingBuffer(unsigned sizeBits) :
+		slots(1UL << sizeBits),
+		mask((1UL << sizeBits) - 1),
+		head(0),
+		tail(0)
+	{}
+
+	bool push(const T &value)
+	{
+		size_t next = (head + 1) & mask;
+		if (next == tail)
+		{
+			return false;
+		}
+		slots[head] = value;
+		__sync_synchronize();
+		head = next;
+		return true;
+	}
+
+	bool pop(T &value)
+	{
+		if (tail == head)
+		{
+			return false;
+		}
+		__sync_synchronize();
+		value = slots[tail];
+		__sync_synchronize();
+		tail = (tail + 1) & mask;
+		return true;
+	}
+
+	bool empty() const
+	{
+		return tail == head;
+	}
+
+private:
+	std::vector<T> slots;
+	const size_t mask;
+	volatile size_t head;
+	volatile size_t tail;
+};
+}
+
+#endif
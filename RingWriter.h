@@ -0,0 +1,150 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef RINGWRITER_H
+#define RINGWRITER_H
+
+//RingWriter.h
+//
+//A ring buffer drained to disk by a thread of its own
+//
+
+#include <pthread.h>
+#include <unistd.h>
+#include "RingBuffer.h"
+
+namespace DRAMSim
+{
+/*
+ * Base of the output streams that are written from a thread of their own so
+ * the simulation never waits on the disk (Sampler, CommandTrace and the log).
+ * The simulation thread push()es items onto the ring; the writer thread
+ * hands every item to write(), calls caughtUp() after each batch and sleeps
+ * for sleepMicroseconds whenever the ring is empty. What to do when the ring
+ * is full is up to the owner.
+ *
+ * stop() writes everything pushed before it was called and joins the
+ * writer. Since the writer calls into the derived class, the derived
+ * destructor has to stop() it; by the time this destructor runs the derived
+ * part is already gone.
+ */
+template <typename T>
+class RingWriter
+{
+public:
+	RingWriter(unsigned sizeBits, unsigned sleepMicroseconds_) :
+		ring(sizeBits),
+		sleepMicroseconds(sleepMicroseconds_),
+		running(false),
+		stopping(false)
+	{}
+
+	virtual ~RingWriter() {}
+
+	bool push(const T &item)
+	{
+		return ring.push(item);
+	}
+
+	bool isRunning() const
+	{
+		return running;
+	}
+
+	// false if the thread couldn't be started
+	bool start()
+	{
+		stopping = false;
+		if (pthread_create(&thread, NULL, writerThread, this) != 0)
+		{
+			return false;
+		}
+		running = true;
+		return true;
+	}
+
+	void stop()
+	{
+		if (!running)
+		{
+			return;
+		}
+		__sync_synchronize();
+		stopping = true;
+		pthread_join(thread, NULL);
+		running = false;
+	}
+
+protected:
+	virtual void write(T &item) = 0;
+	virtual void caughtUp() {}
+
+private:
+	static void *writerThread(void *ringWriter)
+	{
+		RingWriter<T> *self = (RingWriter<T> *)ringWriter;
+		T item;
+		while (true)
+		{
+			// read the flag first so nothing pushed before it was set is missed
+			bool stopRequested = self->stopping;
+			__sync_synchronize();
+			bool wrote = false;
+			while (self->ring.pop(item))
+			{
+				self->write(item);
+				wrote = true;
+			}
+			if (wrote)
+			{
+				self->caughtUp();
+			}
+			if (stopRequested)
+			{
+				break;
+			}
+			if (!wrote)
+			{
+				usleep(self->sleepMicroseconds);
+			}
+		}
+		return NULL;
+	}
+
+	RingBuffer<T> ring;
+	const unsigned sleepMicroseconds;
+	pthread_t thread;
+	bool running;
+	volatile bool stopping;
+};
+}
+
+#endif
@@ -0,0 +1,84 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+//Sampler.cpp
+//
+//Writes the fine grained time series of the memory controllers
+//
+
+#include "Sampler.h"
+#include "SystemConfiguration.h"
+#include "PrintMacros.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+// 64k samples: over half a second of simulated time for four channels
+//	sampled every 100 cycles, far more than the writer ever lags behind
+static const unsigned SAMPLE_BUFFER_BITS = 16;
+static const unsigned SAMPLE_WRITER_SLEEP_US = 1000;
+
+Sampler::Sampler(const string &filename_) :
+	RingWriter<Sample>(SAMPLE_BUFFER_BITS, SAMPLE_WRITER_SLEEP_US),
+	filename(filename_),
+	out(filename_.c_str()),
+	dropped(0)
+{
+	if (!out)
+	{
+		ERROR("Cannot open '"<<filename<<"'");
+		exit(-1);
+	}
+	out << "cycle,ms,channel,transaction_queue,command_queue,outstanding_reads,bandwidth" << endl;
+	if (!start())
+	{
+		ERROR("Cannot start the sample writer thread");
+		exit(-1);
+	}
+}
+
+Sampler::~Sampler()
+{
+	stop();
+	out.close();
+	if (dropped > 0)
+	{
+		cerr << "WARNING: dropped " << dropped << " samples because " << filename << " couldn't be written fast enough" << endl;
+	}
+}
+
+void Sampler::write(Sample &sample)
+{
+	out << sample.cycle << ',' << sample.cycle * tCK * 1E-6 << ',' << sample.channel << ','
+		<< sample.transactionQueue << ',' << sample.commandQueue << ',' << sample.outstandingReads << ','
+		<< sample.bandwidth << '\n';
+}
+}
@@ -0,0 +1,86 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+//Sampler.h
+//
+//Header file for the fine grained time series of the memory controllers
+//
+
+#include <fstream>
+#include <string>
+#include "RingWriter.h"
+
+using std::string;
+
+namespace DRAMSim
+{
+// the state of one channel every SAMPLE_INTERVAL cycles
+struct Sample
+{
+	uint64_t cycle;
+	unsigned channel;
+	unsigned transactionQueue;
+	unsigned commandQueue;
+	unsigned outstandingReads;
+	double bandwidth; // GB/s since the channel's previous sample
+};
+
+/*
+ * Collects samples from the simulation thread and writes them to a CSV file
+ * from a writer thread. When the writer falls behind and the ring is full,
+ * samples are dropped (and counted) rather than slowing the simulation down.
+ */
+class Sampler : private RingWriter<Sample>
+{
+public:
+	Sampler(const string &filename);
+	~Sampler();
+	void add(const Sample &sample)
+	{
+		if (!push(sample))
+		{
+			dropped++;
+		}
+	}
+
+	const string filename;
+
+private:
+	void write(Sample &sample);
+
+	std::ofstream out;
+	uint64_t dropped;
+};
+}
+
+#endif
@@ -60,6 +60,7 @@ extern std::ofstream cmd_verify_out; //used by BusPacket.cpp if VERIFICATION_OUT
 
 //TODO: namespace these to DRAMSim:: 
 extern bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
+extern bool COMMAND_TRACE_OUTPUT; // the same commands in binary, one file per channel (see cmdtrace2txt.py)
 
 extern bool DEBUG_TRANS_Q;
 extern bool DEBUG_CMD_Q;
@@ -70,6 +71,21 @@ extern bool DEBUG_BANKS;
 extern bool DEBUG_POWER;
 extern bool USE_LOW_POWER;
 extern bool VIS_FILE_OUTPUT;
+extern bool VIS_FILE_BINARY;
+
+// make release compiles the debug and verification output out of the
+//	simulation loop; the ini keys are still read (see IniReader.cpp) but
+//	every check of them is a constant false the compiler can drop
+#ifdef DRAMSIM_RELEASE
+#define VERIFICATION_OUTPUT false
+#define DEBUG_TRANS_Q false
+#define DEBUG_CMD_Q false
+#define DEBUG_ADDR_MAP false
+#define DEBUG_BANKSTATE false
+#define DEBUG_BUS false
+#define DEBUG_BANKS false
+#define DEBUG_POWER false
+#endif
 
 extern uint64_t TOTAL_STORAGE;
 extern unsigned NUM_BANKS;
@@ -125,6 +141,7 @@ extern unsigned TRANS_QUEUE_DEPTH;
 extern unsigned CMD_QUEUE_DEPTH;
 
 extern unsigned EPOCH_LENGTH;
+extern unsigned SAMPLE_INTERVAL;
 
 extern unsigned TOTAL_ROW_ACCESSES;
 
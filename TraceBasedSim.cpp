@@ -38,374 +38,1254 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <getopt.h>
+#include <cmath>
 #include <map>
-#include <list>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <utime.h>
+#include <pthread.h>
 
 #include "SystemConfiguration.h"
 #include "MemorySystem.h"
 #include "MultiChannelMemorySystem.h"
 #include "Transaction.h"
 #include "IniReader.h"
+#include "TraceReader.h"
+#include "TraceDriver.h"
+#include "TransactionReceiver.h"
+#include "TrafficGenerator.h"
+#include "TraceTransform.h"
+#include "RequestRecorder.h"
+#include "Checkpoint.h"
+#include "AddressMapping.h"
+#include "Profiler.h"
 
 
 using namespace DRAMSim;
 using namespace std;
 
-//#define RETURN_TRANSACTIONS 1
-
 #ifndef _SIM_
 int SHOW_SIM_OUTPUT = 1;
 ofstream visDataOut; //mostly used in MemoryController
 
-#ifdef RETURN_TRANSACTIONS
-class TransactionReceiver
-{
-	private: 
-		map<uint64_t, list<uint64_t> > pendingReadRequests; 
-		map<uint64_t, list<uint64_t> > pendingWriteRequests; 
-
-	public: 
-		void add_pending(const Transaction &t, uint64_t cycle)
-		{
-			// C++ lists are ordered, so the list will always push to the back and
-			// remove at the front to ensure ordering
-			if (t.transactionType == DATA_READ)
-			{
-				pendingReadRequests[t.address].push_back(cycle); 
-			}
-			else if (t.transactionType == DATA_WRITE)
-			{
-				pendingWriteRequests[t.address].push_back(cycle); 
-			}
-			else
-			{
-				ERROR("This should never happen"); 
-				exit(-1);
-			}
-		}
-
-		void read_complete(unsigned id, uint64_t address, uint64_t done_cycle)
-		{
-			map<uint64_t, list<uint64_t> >::iterator it;
-			it = pendingReadRequests.find(address); 
-			if (it == pendingReadRequests.end())
-			{
-				ERROR("Cant find a pending read for this one"); 
-				exit(-1);
-			}
-			else
-			{
-				if (it->second.size() == 0)
-				{
-					ERROR("Nothing here, either"); 
-					exit(-1); 
-				}
-			}
-
-			uint64_t added_cycle = pendingReadRequests[address].front();
-			uint64_t latency = done_cycle - added_cycle;
-
-			pendingReadRequests[address].pop_front();
-			cout << "Read Callback:  0x"<< std::hex << address << std::dec << " latency="<<latency<<"cycles ("<< done_cycle<< "->"<<added_cycle<<")"<<endl;
-		}
-		void write_complete(unsigned id, uint64_t address, uint64_t done_cycle)
-		{
-			map<uint64_t, list<uint64_t> >::iterator it;
-			it = pendingWriteRequests.find(address); 
-			if (it == pendingWriteRequests.end())
-			{
-				ERROR("Cant find a pending read for this one"); 
-				exit(-1);
-			}
-			else
-			{
-				if (it->second.size() == 0)
-				{
-					ERROR("Nothing here, either"); 
-					exit(-1); 
-				}
-			}
-
-			uint64_t added_cycle = pendingWriteRequests[address].front();
-			uint64_t latency = done_cycle - added_cycle;
-
-			pendingWriteRequests[address].pop_front();
-			cout << "Write Callback: 0x"<< std::hex << address << std::dec << " latency="<<latency<<"cycles ("<< done_cycle<< "->"<<added_cycle<<")"<<endl;
-		}
-};
-#endif
-
 void usage()
 {
 	cout << "DRAMSim2 Usage: " << endl;
 	cout << "DRAMSim -t tracefile -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-o OPTION_A=1234,tRC=14,tFAW=19]" <<endl;
-	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run  "<<endl;
+	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run (repeat -t to replay several traces as separate sources)"<<endl;
 	cout << "\t-s, --systemini=FILENAME \tspecify an ini file that describes the memory system parameters  "<<endl;
 	cout << "\t-d, --deviceini=FILENAME \tspecify an ini file that describes the device-level parameters"<<endl;
 	cout << "\t-c, --numcycles=# \t\tspecify number of cycles to run the simulation for [default=30] "<<endl;
+	cout << "\t--record=FILENAME \t\tRecord every request accepted by the memory system (see also the DRAMSIM_RECORD environment variable)"<<endl;
+	cout << "\t--replay=FILENAME \t\tReplay a request recording instead of a tracefile"<<endl;
+	cout << "\t--run-to-completion \t\trun until the trace is exhausted and the memory system has drained (-c becomes a limit) "<<endl;
+	cout << "\t--fast-forward=# \t\tApply requests functionally (open rows and refresh only, no timing) up to cycle #, then simulate in detail"<<endl;
+	cout << "\t--fast-forward-records=# \tFast-forward through the first # requests (with --fast-forward, whichever comes first)"<<endl;
+	cout << "\t--engine=detailed|analytical \tTime requests cycle by cycle or with the calibrated analytical model [default=detailed]"<<endl;
+	cout << "\t--coefficients=FILENAME \tCoefficients for the analytical model, as written by --calibrate"<<endl;
+	cout << "\t--calibrate=FILENAME \t\tFit the analytical model to this (detailed) run, report its error and save the coefficients"<<endl;
+	cout << "\t--segments=# \t\t\tTime-parallel: split the trace into # segments simulated on their own threads, then stitch the results"<<endl;
+	cout << "\t--segment-warmup=# \t\tCycles each segment simulates (unmeasured) before its start, rounded up to whole epochs [default=one epoch]"<<endl;
+	cout << "\t--split-trace=DIRECTORY \t\tWrite the records of each channel to DIRECTORY/TRACENAME.chN (no simulation)"<<endl;
+	cout << "\t--channel=# \t\t\tSimulate and report only channel # (for running a trace shard; see shard_sim.py)"<<endl;
+	cout << "\t--profile[=#] \t\t\tTime the simulator's phases, report speed and an ETA every # seconds and a profile at the end [default=10]"<<endl;
+	cout << "\t--save-checkpoint=FILENAME \tSave the memory system and trace position at the end of the run"<<endl;
+	cout << "\t--restore-checkpoint=FILENAME \tContinue from a saved checkpoint (same ini files and traffic options; -c still counts from cycle 0)"<<endl;
+	cout << "\t--sweep=KEY=a:b,KEY2=c:d \tWarm up once, then fork a copy of the simulation for every combination of values"<<endl;
+	cout << "\t\t\t\t\t(TRANS_QUEUE_DEPTH, CMD_QUEUE_DEPTH, SCHEDULING_POLICY, TOTAL_ROW_ACCESSES)"<<endl;
+	cout << "\t--sweep-warmup=# \t\tCycles simulated before forking the sweep variants [default=0]"<<endl;
+	cout << "\t--sweep-jobs=# \t\t\tNumber of sweep variants run at the same time [default=number of CPUs]"<<endl;
+	cout << "\t--sweep-output=PREFIX \t\tVariant i writes PREFIX.i.txt (stats) and PREFIX.i.vis [default=sweep]"<<endl;
+	cout << "\t--grid=KEY=a:b,KEY2=c:d \tRun a separate simulation from cycle 0 for every combination of values (any ini key)"<<endl;
+	cout << "\t\t\t\t\tand print one table of the results; uses --sweep-jobs and --sweep-output"<<endl;
+	cout << "\t--queue-init=DIRECTORY \t\tCreate a job queue with one job per --grid configuration (no simulation)"<<endl;
+	cout << "\t--queue-work=DIRECTORY \t\tRun jobs from a queue until it is empty; start as many workers as wanted, on any machine sharing the directory"<<endl;
+	cout << "\t--queue-timeout=# \t\tSeconds without a heartbeat before a running job is requeued [default=60]"<<endl;
+	cout << "\t--queue-merge=DIRECTORY \tPrint the results of a queue as one table (and DIRECTORY/results.csv)"<<endl;
 	cout << "\t-q, --quiet \t\t\tflag to suppress simulation output (except final stats) [default=no]"<<endl;
 	cout << "\t-o, --option=OPTION_A=234,tFAW=14\t\t\toverwrite any ini file option from the command line"<<endl;
 	cout << "\t-p, --pwd=DIRECTORY\t\tSet the working directory (i.e. usually DRAMSim directory where ini/ and results/ are)"<<endl;
 	cout << "\t-S, --size=# \t\t\tSize of the memory system in megabytes [default=2048M]"<<endl;
 	cout << "\t-n, --notiming \t\t\tDo not use the clock cycle information in the trace file"<<endl;
 	cout << "\t-v, --visfile \t\t\tVis output filename"<<endl;
+	cout << "\t-g, --generate=pattern=random,rate=0.5,... \tUse the synthetic traffic generator instead of a tracefile"<<endl;
+	cout << "\t\t\t\t\tpattern=seq|random|strided|bankconflict|rowhit, rate=requests/cycle, footprint=64M,"<<endl;
+	cout << "\t\t\t\t\tstride=4K, hitrate=0.8 (rowhit), reads=0.67, count=#, seed=#"<<endl;
+	cout << "\t--build-index[=#] \t\t(Re)build the tracefile.idx sidecar with an entry every # records [default=1000000]"<<endl;
+	cout << "\t--window-start=# \t\tSampled simulation: first record of the first window"<<endl;
+	cout << "\t--window-length=# \t\tSampled simulation: number of records measured per window"<<endl;
+	cout << "\t--window-period=# \t\tSampled simulation: records from the start of one window to the next [default=one window]"<<endl;
+	cout << "\t--window-count=# \t\tSampled simulation: maximum number of windows [default=as many as fit]"<<endl;
+	cout << "\t--warmup=# \t\t\tSampled simulation: records simulated (but not measured) before each window [default=0]"<<endl;
+	cout << "\t--closed-loop=# \t\tReplay closed loop with at most # reads outstanding [default=0 (open loop)]"<<endl;
+	cout << "\t--rate-scale=# \t\t\tReplay at # times the trace's request rate, e.g. 0.5 or 4 [default=1]"<<endl;
+	cout << "\t--replicate=# \t\t\tReplay # copies of each trace as separate sources with their addresses offset [default=1]"<<endl;
+	cout << "\t--replicate-offset=# \t\tBytes between the addresses of consecutive copies [default=memory size/copies]"<<endl;
+	cout << "\t\t\t\t\tCompletions carry only an address: sources that share addresses may have requests counted against each other"<<endl;
 }
 #endif
 
-void *parseTraceFileLine(string &line, uint64_t &addr, enum TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle)
+#ifndef _SIM_
+
+// options that only have a long form
+enum LongOnlyOptions
 {
-	size_t previousIndex=0;
-	size_t spaceIndex=0;
-	uint64_t *dataBuffer = NULL;
-	string addressStr="", cmdStr="", dataStr="", ccStr="";
+	OPT_BUILD_INDEX = 256,
+	OPT_WINDOW_START,
+	OPT_WINDOW_LENGTH,
+	OPT_WINDOW_PERIOD,
+	OPT_WINDOW_COUNT,
+	OPT_WARMUP,
+	OPT_CLOSED_LOOP,
+	OPT_RATE_SCALE,
+	OPT_REPLICATE,
+	OPT_REPLICATE_OFFSET,
+	OPT_RUN_TO_COMPLETION,
+	OPT_RECORD,
+	OPT_REPLAY,
+	OPT_SAVE_CHECKPOINT,
+	OPT_RESTORE_CHECKPOINT,
+	OPT_SWEEP,
+	OPT_SWEEP_WARMUP,
+	OPT_SWEEP_JOBS,
+	OPT_SWEEP_OUTPUT,
+	OPT_GRID,
+	OPT_QUEUE_INIT,
+	OPT_QUEUE_WORK,
+	OPT_QUEUE_TIMEOUT,
+	OPT_QUEUE_MERGE,
+	OPT_FAST_FORWARD,
+	OPT_FAST_FORWARD_RECORDS,
+	OPT_ENGINE,
+	OPT_COEFFICIENTS,
+	OPT_CALIBRATE,
+	OPT_SEGMENTS,
+	OPT_SEGMENT_WARMUP,
+	OPT_SPLIT_TRACE,
+	OPT_CHANNEL,
+	OPT_PROFILE
+};
 
-	switch (type)
-	{
-	case k6:
-	{
-		spaceIndex = line.find_first_of(" ", 0);
+static const uint64_t DEFAULT_INDEX_INTERVAL = 1000000;
+// seconds between --profile progress reports
+static const double DEFAULT_PROFILE_INTERVAL = 10.0;
+
+struct WindowOptions
+{
+	uint64_t start;
+	uint64_t length;
+	uint64_t period;
+	uint64_t count;
+	uint64_t warmup;
+};
 
-		addressStr = line.substr(0, spaceIndex);
-		previousIndex = spaceIndex;
+IniReader::OverrideMap *parseParamOverrides(const string &kv_str);
 
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		cmdStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
-		previousIndex = line.find_first_of(" ", spaceIndex);
+void registerReceiver(MultiChannelMemorySystem *memorySystem, TransactionReceiver *receiver)
+{
+	/* create and register our callback functions */
+	Callback_t *read_cb = new Callback<TransactionReceiver, void, unsigned, uint64_t, uint64_t>(receiver, &TransactionReceiver::read_complete);
+	Callback_t *write_cb = new Callback<TransactionReceiver, void, unsigned, uint64_t, uint64_t>(receiver, &TransactionReceiver::write_complete);
+	memorySystem->RegisterCallbacks(read_cb, write_cb, NULL);
+}
 
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		ccStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
+/**
+ * A TraceBasedSim checkpoint is the memory system state followed by the
+ * driver's position in the traffic and, when there is one, the receiver's
+ * list of requests in flight.
+ **/
+void saveCheckpoint(const string &filename, MultiChannelMemorySystem *memorySystem, const TraceDriver &driver, const TransactionReceiver *receiver)
+{
+	CheckpointWriter checkpoint(filename);
+	memorySystem->saveState(checkpoint);
+	driver.saveState(checkpoint);
+	checkpoint.write<bool>(receiver != NULL);
+	if (receiver)
+	{
+		receiver->saveState(checkpoint);
+	}
+	checkpoint.writeSection(CHECKPOINT_END);
+	checkpoint.close();
+	cout << "== Saved checkpoint at cycle "<<driver.currentClockCycle<<" to '"<<filename<<"' =="<<endl;
+}
 
-		if (cmdStr.compare("P_MEM_WR")==0 ||
-		        cmdStr.compare("BOFF")==0)
-		{
-			transType = DATA_WRITE;
-		}
-		else if (cmdStr.compare("P_FETCH")==0 ||
-		         cmdStr.compare("P_MEM_RD")==0 ||
-		         cmdStr.compare("P_LOCK_RD")==0 ||
-		         cmdStr.compare("P_LOCK_WR")==0)
+void restoreCheckpoint(const string &filename, MultiChannelMemorySystem *memorySystem, TraceDriver &driver, TransactionReceiver *receiver)
+{
+	CheckpointReader checkpoint(filename);
+	memorySystem->restoreState(checkpoint);
+	driver.restoreState(checkpoint);
+	bool hasReceiver;
+	checkpoint.read(hasReceiver);
+	if (hasReceiver != (receiver != NULL))
+	{
+		ERROR("Checkpoint '"<<filename<<"' was saved with different traffic options (closed loop or number of sources)");
+		exit(-1);
+	}
+	if (receiver)
+	{
+		receiver->restoreState(checkpoint);
+	}
+	checkpoint.readSection(CHECKPOINT_END);
+	cout << "== Restored checkpoint from '"<<filename<<"' at cycle "<<driver.currentClockCycle<<" =="<<endl;
+}
+
+/**
+ * A sweep grid uses the override syntax with a colon separated list of
+ * values per key (KEY=a:b,KEY2=c:d); every combination of values is one
+ * variant, the same cross product comparison_gen.py generates.
+ **/
+vector<IniReader::OverrideMap> expandSweepGrid(const IniReader::OverrideMap &grid)
+{
+	vector<IniReader::OverrideMap> variants(1);
+	for (IniReader::OverrideIterator it=grid.begin(); it!=grid.end(); it++)
+	{
+		vector<string> values;
+		size_t start=0, colon;
+		do
 		{
-			transType = DATA_READ;
-		}
-		else
+			colon = it->second.find(':', start);
+			values.push_back(it->second.substr(start, colon-start));
+			start = colon+1;
+		} while (colon != string::npos);
+
+		vector<IniReader::OverrideMap> expanded;
+		for (size_t v=0; v<variants.size(); v++)
 		{
-			ERROR("== Unknown Command : "<<cmdStr);
-			exit(0);
+			for (size_t i=0; i<values.size(); i++)
+			{
+				expanded.push_back(variants[v]);
+				expanded.back()[it->first] = values[i];
+			}
 		}
+		variants.swap(expanded);
+	}
+	return variants;
+}
 
-		istringstream a(addressStr.substr(2));//gets rid of 0x
-		a>>hex>>addr;
-
-		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
-		//  will be allowed to be issued
-		if (useClockCycle)
+string overridesToString(const IniReader::OverrideMap &overrides)
+{
+	string str;
+	for (IniReader::OverrideIterator it=overrides.begin(); it!=overrides.end(); it++)
+	{
+		if (str.length() > 0)
 		{
-			istringstream b(ccStr);
-			b>>clockCycle;
+			str += ",";
 		}
-		break;
+		str += it->first + "=" + it->second;
 	}
-	case mase:
-	{
-		spaceIndex = line.find_first_of(" ", 0);
-
-		addressStr = line.substr(0, spaceIndex);
-		previousIndex = spaceIndex;
+	return str;
+}
 
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		cmdStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
-		previousIndex = line.find_first_of(" ", spaceIndex);
+/**
+ * Forks a child for each variant in order, at most maxJobs at a time; a new
+ * one is started whenever a running one exits. Returns the variant number in
+ * the child and -1 in the parent once every child has exited; failed gets
+ * the variants that didn't exit cleanly. The children are copy-on-write
+ * copies of the parent, so whatever it has already done (a warm-up, reading
+ * the traces) is done once however many variants there are.
+ **/
+int forkSweepVariants(const vector<size_t> &order, unsigned maxJobs, vector<size_t> &failed)
+{
+	size_t numVariants = order.size();
+	map<pid_t, size_t> running;
 
-		spaceIndex = line.find_first_not_of(" ", previousIndex);
-		ccStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
+	// anything still buffered would otherwise be written out by every child
+	cout.flush();
+	cerr.flush();
+	fflush(NULL);
 
-		if (cmdStr.compare("IFETCH")==0||
-		        cmdStr.compare("READ")==0)
+	for (size_t i=0; i<numVariants || !running.empty(); )
+	{
+		if (i < numVariants && running.size() < maxJobs)
 		{
-			transType = DATA_READ;
+			pid_t pid = fork();
+			if (pid < 0)
+			{
+				ERROR("Could not fork sweep variant "<<order[i]<<": "<<strerror(errno));
+				exit(-1);
+			}
+			if (pid == 0)
+			{
+				return order[i];
+			}
+			running[pid] = order[i];
+			i++;
+			continue;
 		}
-		else if (cmdStr.compare("WRITE")==0)
+
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0)
 		{
-			transType = DATA_WRITE;
+			ERROR("wait() failed: "<<strerror(errno));
+			exit(-1);
 		}
-		else
+		if (running.count(pid) == 0)
 		{
-			ERROR("== Unknown command in tracefile : "<<cmdStr);
+			continue;
 		}
-
-		istringstream a(addressStr.substr(2));//gets rid of 0x
-		a>>hex>>addr;
-
-		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
-		//  will be allowed to be issued
-		if (useClockCycle)
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
 		{
-			istringstream b(ccStr);
-			b>>clockCycle;
+			failed.push_back(running[pid]);
 		}
+		running.erase(pid);
+	}
+	return -1;
+}
 
-		break;
+/**
+ * Forks every sweep variant off the (warmed-up) memory system. In the
+ * parent this waits for the variants, prints where each one's results went
+ * and returns true. In a child it points stdout and the vis file at the
+ * variant's own result files, applies its overrides, clears the whole-run
+ * stats of the warm-up and returns false so the caller carries on
+ * simulating as that variant.
+ **/
+bool runSweep(MultiChannelMemorySystem *memorySystem, const vector<TraceSource *> &traceSources, uint64_t cycle, const vector<IniReader::OverrideMap> &variants, unsigned maxJobs, const string &prefix)
+{
+	memorySystem->visDataOut.flush();
+	memorySystem->prepareFork();
+	for (size_t i=0; i<traceSources.size(); i++)
+	{
+		traceSources[i]->prepareFork();
 	}
-	case misc:
-		spaceIndex = line.find_first_of(" ", spaceIndex+1);
-		if (spaceIndex == string::npos)
+	vector<size_t> order(variants.size());
+	for (size_t i=0; i<order.size(); i++)
+	{
+		order[i] = i;
+	}
+	vector<size_t> failed;
+	int variant = forkSweepVariants(order, maxJobs, failed);
+	if (variant < 0)
+	{
+		cout << "== Sweep: "<<variants.size()<<" variants forked at cycle "<<cycle<<" =="<<endl;
+		for (size_t i=0; i<variants.size(); i++)
 		{
-			ERROR("Malformed line: '"<< line <<"'");
+			bool ok = find(failed.begin(), failed.end(), i) == failed.end();
+			cout << "   "<<i<<" : "<<overridesToString(variants[i])<<" -> "<<prefix<<"."<<i<<".txt"<<(ok ? "" : " (FAILED)")<<endl;
 		}
+		return true;
+	}
 
-		addressStr = line.substr(previousIndex,spaceIndex);
-		previousIndex=spaceIndex;
+	for (size_t i=0; i<traceSources.size(); i++)
+	{
+		traceSources[i]->reopenAfterFork();
+	}
+	stringstream resultName;
+	resultName << prefix << "." << variant;
+	string resultFilename = resultName.str() + ".txt";
+	if (freopen(resultFilename.c_str(), "w", stdout) == NULL)
+	{
+		ERROR("Could not open '"<<resultFilename<<"': "<<strerror(errno));
+		exit(-1);
+	}
+	cout << "== Sweep variant "<<variant<<" : "<<overridesToString(variants[variant])<<" (forked at cycle "<<cycle<<") =="<<endl;
+	IniReader::OverrideKeys(&variants[variant]);
+	IniReader::InitEnumsFromStrings();
+	// the memory system keeps this pointer for as long as it lives
+	memorySystem->redirectVisFile(new string(resultName.str()));
+	// the warm-up ran under the base configuration; only count the variant's own cycles
+	memorySystem->resetRunStats();
+	return false;
+}
 
-		spaceIndex = line.find_first_of(" ", spaceIndex+1);
-		if (spaceIndex == string::npos)
-		{
-			cmdStr = line.substr(previousIndex+1);
-		}
-		else
-		{
-			cmdStr = line.substr(previousIndex+1,spaceIndex-previousIndex-1);
-			dataStr = line.substr(spaceIndex+1);
-		}
+/**
+ * What a grid job reports back to the parent. The array of these lives in a
+ * shared anonymous mapping so every forked job can fill in its own entry.
+ **/
+struct GridResult
+{
+	bool done;
+	uint64_t cycles;
+	uint64_t reads;
+	uint64_t writes;
+	double bandwidth;
+	double readLatency;
+	double wallSeconds;
+};
 
-		//convert address string -> number
-		istringstream b(addressStr.substr(2)); //substr(2) chops off 0x characters
-		b >>hex>> addr;
+GridResult *mapGridResults(size_t numJobs)
+{
+	void *results = mmap(NULL, numJobs * sizeof(GridResult), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (results == MAP_FAILED)
+	{
+		ERROR("Could not map the grid results: "<<strerror(errno));
+		exit(-1);
+	}
+	// anonymous mappings start out zeroed, so done is false everywhere
+	return (GridResult *)results;
+}
 
-		// parse command
-		if (cmdStr.compare("read") == 0)
-		{
-			transType=DATA_READ;
-		}
-		else if (cmdStr.compare("write") == 0)
-		{
-			transType=DATA_WRITE;
-		}
-		else
+/**
+ * A rough guess at how long a grid configuration takes to simulate: the
+ * work done every cycle grows with the number of channels and banks and
+ * with how deep the queues the scheduler walks are. Only the ratios between
+ * configurations matter; they decide which jobs get started first.
+ **/
+double estimateGridCost(const IniReader::OverrideMap &config)
+{
+	static const char *scalingKeys[] = {"NUM_CHANS", "NUM_BANKS", "TRANS_QUEUE_DEPTH", "CMD_QUEUE_DEPTH"};
+	double cost = 1.0;
+	for (size_t i=0; i<sizeof(scalingKeys)/sizeof(scalingKeys[0]); i++)
+	{
+		IniReader::OverrideIterator it = config.find(scalingKeys[i]);
+		if (it != config.end() && atof(it->second.c_str()) > 0)
 		{
-			ERROR("INVALID COMMAND '"<<cmdStr<<"'");
-			exit(-1);
+			cost *= atof(it->second.c_str());
 		}
-		if (SHOW_SIM_OUTPUT)
+	}
+	return cost;
+}
+
+struct CostlierFirst
+{
+	const vector<double> &costs;
+	CostlierFirst(const vector<double> &costs_) : costs(costs_) {}
+	bool operator()(size_t a, size_t b) const
+	{
+		return costs[a] > costs[b];
+	}
+};
+
+/**
+ * Forks one job per grid configuration, starting the most expensive ones
+ * first so a long job doesn't end up running alone at the end. Returns the
+ * configuration number in a job and -1 in the parent once all are done;
+ * failed gets the jobs that didn't exit cleanly.
+ **/
+int forkGridJobs(const vector<IniReader::OverrideMap> &configs, unsigned maxJobs, vector<size_t> &failed)
+{
+	vector<double> costs(configs.size());
+	vector<size_t> order(configs.size());
+	for (size_t i=0; i<configs.size(); i++)
+	{
+		costs[i] = estimateGridCost(configs[i]);
+		order[i] = i;
+	}
+	stable_sort(order.begin(), order.end(), CostlierFirst(costs));
+	return forkSweepVariants(order, maxJobs, failed);
+}
+
+double wallClockSeconds()
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec + now.tv_usec * 1E-6;
+}
+
+/**
+ * One row per configuration, in grid order, on stdout and in csvFilename.
+ **/
+void printGridTable(const vector<IniReader::OverrideMap> &configs, const GridResult *results, const string &prefix, const string &csvFilename)
+{
+	ofstream csv(csvFilename.c_str());
+	csv << "job,cycles,reads,writes,bandwidth_GBps,read_latency_ns,wall_seconds,config"<<endl;
+
+	cout << "== Grid: "<<configs.size()<<" configurations =="<<endl;
+	cout << "  job       cycles      reads     writes   GB/s   lat(ns)  wall(s)  configuration"<<endl;
+	for (size_t i=0; i<configs.size(); i++)
+	{
+		const GridResult &r = results[i];
+		string config = overridesToString(configs[i]);
+		if (!r.done)
 		{
-			DEBUGN("ADDR='"<<hex<<addr<<dec<<"',CMD='"<<transType<<"'");//',DATA='"<<dataBuffer[0]<<"'");
+			cout << setw(5) << i << "  FAILED (see "<<prefix<<"."<<i<<".txt)  "<<config<<endl;
+			csv << i << ",,,,,,,\"" << config << "\"" << endl;
+			continue;
 		}
+		cout << setw(5) << i << setw(13) << r.cycles << setw(11) << r.reads << setw(11) << r.writes
+			<< fixed << setprecision(3) << setw(7) << r.bandwidth << setprecision(2) << setw(10) << r.readLatency
+			<< setw(9) << r.wallSeconds << "  " << config << endl;
+		cout.unsetf(ios::floatfield);
+		cout << setprecision(6);
+		csv << i << "," << r.cycles << "," << r.reads << "," << r.writes << "," << r.bandwidth << ","
+			<< r.readLatency << "," << r.wallSeconds << ",\"" << config << "\"" << endl;
+	}
+	cout << "== Results also written to '"<<csvFilename<<"' =="<<endl;
+}
+
+/**
+ * Turns a freshly forked process into job resultName: stdout goes to
+ * resultName.txt, the vis file to resultName.vis and the job's values win
+ * over the same keys given with -o.
+ **/
+void setUpJob(const string &resultName, const IniReader::OverrideMap &config, IniReader::OverrideMap *&paramOverrides, string *&visFilename)
+{
+	string resultFilename = resultName + ".txt";
+	if (freopen(resultFilename.c_str(), "w", stdout) == NULL)
+	{
+		ERROR("Could not open '"<<resultFilename<<"': "<<strerror(errno));
+		exit(-1);
+	}
+	cout << "== Job "<<resultName<<" : "<<overridesToString(config)<<" =="<<endl;
+	if (paramOverrides == NULL)
+	{
+		paramOverrides = new IniReader::OverrideMap();
+	}
+	for (IniReader::OverrideIterator it=config.begin(); it!=config.end(); it++)
+	{
+		(*paramOverrides)[it->first] = it->second;
+	}
+	delete visFilename;
+	visFilename = new string(resultName);
+}
+
+/*
+ * Job queue: a directory on a shared filesystem that any number of workers
+ * on any number of machines pull grid configurations out of.
+ *
+ *   DIR/jobs                    one line per job: number and overrides
+ *   DIR/pending/RANK-JOB.job    not started yet; workers take the lowest
+ *                               name, and ranks put the costliest first
+ *   DIR/running/NAME.HOST.PID   claimed by that worker; the file's mtime is
+ *                               its heartbeat
+ *   DIR/done/NAME               finished (or failed)
+ *   DIR/results/job.JOB.*       the job's stats, vis file and result line
+ *
+ * A job is claimed by renaming it from pending/ to running/; rename() is
+ * atomic, so of several workers going for the same job exactly one wins.
+ * The worker forks the simulation and touches its running/ file every
+ * second while it waits. A running/ file that hasn't been touched for the
+ * timeout belongs to a worker that died and is renamed back to pending/.
+ */
+static const unsigned QUEUE_HEARTBEAT_SECONDS = 1;
+
+string queuePath(const string &dir, const string &subdir, const string &name="")
+{
+	return dir + "/" + subdir + (name.length() > 0 ? "/" + name : "");
+}
 
-		//parse data
-		//if we are running in a no storage mode, don't allocate space, just return NULL
-#ifndef NO_STORAGE
-		if (dataStr.size() > 0 && transType == DATA_WRITE)
+string queueResultName(const string &dir, size_t job)
+{
+	stringstream name;
+	name << queuePath(dir, "results", "job") << "." << job;
+	return name.str();
+}
+
+vector<string> listDirectory(const string &path)
+{
+	vector<string> names;
+	DIR *dir = opendir(path.c_str());
+	if (dir == NULL)
+	{
+		ERROR("Could not open directory '"<<path<<"': "<<strerror(errno));
+		exit(-1);
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		if (entry->d_name[0] != '.')
 		{
-			// 32 bytes of data per transaction
-			dataBuffer = (uint64_t *)calloc(sizeof(uint64_t),4);
-			size_t strlen = dataStr.size();
-			for (int i=0; i < 4; i++)
-			{
-				size_t startIndex = i*16;
-				if (startIndex > strlen)
-				{
-					break;
-				}
-				size_t charsLeft = min(((size_t)16), strlen - startIndex + 1);
-				string piece = dataStr.substr(i*16,charsLeft);
-				istringstream iss(piece);
-				iss >> hex >> dataBuffer[i];
-			}
-			PRINTN("\tDATA=");
-			BusPacket::printData(dataBuffer);
+			names.push_back(entry->d_name);
 		}
-
-		PRINT("");
-#endif
-		break;
 	}
-	return dataBuffer;
+	closedir(dir);
+	sort(names.begin(), names.end());
+	return names;
 }
 
-#ifndef _SIM_
+void makeDirectory(const string &path)
+{
+	if (mkdir(path.c_str(), 0777) != 0 && errno != EEXIST)
+	{
+		ERROR("Could not create directory '"<<path<<"': "<<strerror(errno));
+		exit(-1);
+	}
+}
 
-void alignTransactionAddress(Transaction &trans)
+void initJobQueue(const string &dir, const vector<IniReader::OverrideMap> &configs)
 {
-	// zero out the low order bits which correspond to the size of a transaction
+	makeDirectory(dir);
+	const char *subdirs[] = {"pending", "running", "done", "results"};
+	for (size_t i=0; i<sizeof(subdirs)/sizeof(subdirs[0]); i++)
+	{
+		makeDirectory(queuePath(dir, subdirs[i]));
+	}
+	if (listDirectory(queuePath(dir, "pending")).size() + listDirectory(queuePath(dir, "running")).size() +
+			listDirectory(queuePath(dir, "done")).size() > 0)
+	{
+		ERROR("'"<<dir<<"' already holds a job queue");
+		exit(-1);
+	}
 
-	unsigned throwAwayBits = dramsim_log2((BL*JEDEC_DATA_BUS_BITS/8));
+	vector<double> costs(configs.size());
+	vector<size_t> order(configs.size());
+	for (size_t i=0; i<configs.size(); i++)
+	{
+		costs[i] = estimateGridCost(configs[i]);
+		order[i] = i;
+	}
+	stable_sort(order.begin(), order.end(), CostlierFirst(costs));
 
-	trans.address >>= throwAwayBits;
-	trans.address <<= throwAwayBits;
+	ofstream jobs(queuePath(dir, "jobs").c_str());
+	for (size_t i=0; i<configs.size(); i++)
+	{
+		jobs << i << " " << overridesToString(configs[i]) << endl;
+	}
+	for (size_t rank=0; rank<order.size(); rank++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "%06u-%06u.job", (unsigned)rank, (unsigned)order[rank]);
+		ofstream job(queuePath(dir, "pending", name).c_str());
+		job << overridesToString(configs[order[rank]]) << endl;
+	}
+	cout << "== Queued "<<configs.size()<<" jobs in '"<<dir<<"' =="<<endl;
 }
 
-/** 
- * Override options can be specified on the command line as -o key1=value1,key2=value2
- * this method should parse the key-value pairs and put them into a map 
- **/ 
-IniReader::OverrideMap *parseParamOverrides(const string &kv_str)
+// puts the jobs of workers that stopped sending heartbeats back in pending/
+void requeueStaleJobs(const string &dir, unsigned timeout)
 {
-	IniReader::OverrideMap *kv_map = new IniReader::OverrideMap(); 
-	size_t start = 0, comma=0, equal_sign=0;
-	// split the commas if they are there
-	while (1)
+	vector<string> running = listDirectory(queuePath(dir, "running"));
+	time_t now = time(NULL);
+	for (size_t i=0; i<running.size(); i++)
 	{
-		equal_sign = kv_str.find('=', start); 
-		if (equal_sign == string::npos)
+		string path = queuePath(dir, "running", running[i]);
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0 || now - info.st_mtime <= (time_t)timeout)
 		{
-			break;
+			continue;
 		}
-
-		comma = kv_str.find(',', equal_sign);
-		if (comma == string::npos)
+		string jobName = running[i].substr(0, running[i].find(".job") + 4);
+		if (rename(path.c_str(), queuePath(dir, "pending", jobName).c_str()) == 0)
 		{
-			comma = kv_str.length();
+			cerr << "== Requeued '"<<jobName<<"' (no heartbeat from '"<<running[i]<<"' for "<<now - info.st_mtime<<"s) =="<<endl;
 		}
-
-		string key = kv_str.substr(start, equal_sign-start);
-		string value = kv_str.substr(equal_sign+1, comma-equal_sign-1); 
-
-		(*kv_map)[key] = value; 
-		start = comma+1;
-
 	}
-	return kv_map; 
 }
 
-int main(int argc, char **argv)
+// takes the first pending job nobody else got to first
+bool claimJob(const string &dir, string &jobName, string &claimedPath)
 {
-	int c;
-	TraceType traceType;
-	string traceFileName;
-	string systemIniFilename("system.ini");
-	string deviceIniFilename;
-	string pwdString;
-	string *visFilename = NULL;
-	unsigned megsOfMemory=2048;
-	bool useClockCycle=true;
-	
-	IniReader::OverrideMap *paramOverrides = NULL; 
+	char host[256];
+	if (gethostname(host, sizeof(host)) != 0)
+	{
+		strcpy(host, "unknown");
+	}
+	host[sizeof(host)-1] = '\0';
+	stringstream owner;
+	owner << "." << host << "." << getpid();
 
-	unsigned numCycles=1000;
-	//getopt stuff
-	while (1)
+	vector<string> pending = listDirectory(queuePath(dir, "pending"));
+	for (size_t i=0; i<pending.size(); i++)
 	{
-		static struct option long_options[] =
+		claimedPath = queuePath(dir, "running", pending[i] + owner.str());
+		if (rename(queuePath(dir, "pending", pending[i]).c_str(), claimedPath.c_str()) == 0)
 		{
-			{"deviceini", required_argument, 0, 'd'},
-			{"tracefile", required_argument, 0, 't'},
-			{"systemini", required_argument, 0, 's'},
+			jobName = pending[i];
+			return true;
+		}
+	}
+	return false;
+}
 
-			{"pwd", required_argument, 0, 'p'},
-			{"numcycles",  required_argument,	0, 'c'},
-			{"option",  required_argument,	0, 'o'},
-			{"quiet",  no_argument, &SHOW_SIM_OUTPUT, 'q'},
-			{"help", no_argument, 0, 'h'},
-			{"size", required_argument, 0, 'S'},
-			{"visfile", required_argument, 0, 'v'},
-			{0, 0, 0, 0}
-		};
-		int option_index=0; //for getopt
-		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:v:qn", long_options, &option_index);
-		if (c == -1)
+/**
+ * Runs jobs from the queue one after the other until there are none left
+ * pending or running. Every job is simulated in a forked process, which
+ * returns from here with the job's number and overrides; the worker itself
+ * returns -1 once the queue is empty.
+ **/
+int runQueueWorker(const string &dir, unsigned timeout, GridResult *result, IniReader::OverrideMap &config)
+{
+	while (true)
+	{
+		requeueStaleJobs(dir, timeout);
+		string jobName, claimedPath;
+		if (!claimJob(dir, jobName, claimedPath))
 		{
-			break;
-		}
+			if (listDirectory(queuePath(dir, "running")).size() == 0)
+			{
+				return -1;
+			}
+			// others are still busy; wait in case one of them dies
+			sleep(QUEUE_HEARTBEAT_SECONDS);
+			continue;
+		}
+
+		unsigned rank, job;
+		string overrides;
+		ifstream jobFile(claimedPath.c_str());
+		getline(jobFile, overrides);
+		jobFile.close();
+		if (sscanf(jobName.c_str(), "%u-%u.job", &rank, &job) != 2)
+		{
+			ERROR("Malformed job name '"<<jobName<<"'");
+			exit(-1);
+		}
+		cerr << "== Running job "<<job<<" : "<<overrides<<" =="<<endl;
+
+		memset(result, 0, sizeof(GridResult));
+		cout.flush();
+		cerr.flush();
+		fflush(NULL);
+		pid_t pid = fork();
+		if (pid < 0)
+		{
+			ERROR("Could not fork job "<<job<<": "<<strerror(errno));
+			exit(-1);
+		}
+		if (pid == 0)
+		{
+			IniReader::OverrideMap *parsed = parseParamOverrides(overrides);
+			config = *parsed;
+			delete parsed;
+			return job;
+		}
+
+		int status;
+		while (waitpid(pid, &status, WNOHANG) == 0)
+		{
+			utime(claimedPath.c_str(), NULL);
+			sleep(QUEUE_HEARTBEAT_SECONDS);
+		}
+		if (result->done)
+		{
+			// write then rename so a merge never sees half a result
+			string resultFilename = queueResultName(dir, job) + ".result";
+			string tempFilename = claimedPath + ".result";
+			ofstream resultFile(tempFilename.c_str());
+			resultFile << setprecision(17) << result->cycles << " " << result->reads << " " << result->writes << " "
+				<< result->bandwidth << " " << result->readLatency << " " << result->wallSeconds << endl;
+			resultFile.close();
+			rename(tempFilename.c_str(), resultFilename.c_str());
+		}
+		else
+		{
+			ERROR("Job "<<job<<" failed; see '"<<queueResultName(dir, job)<<".txt'");
+		}
+		// if this fails the job was requeued meanwhile and will simply run again
+		rename(claimedPath.c_str(), queuePath(dir, "done", jobName).c_str());
+	}
+}
+
+// collects whatever results are in the queue into one table
+void mergeJobQueue(const string &dir)
+{
+	ifstream jobs(queuePath(dir, "jobs").c_str());
+	if (!jobs.is_open())
+	{
+		ERROR("'"<<dir<<"' doesn't hold a job queue");
+		exit(-1);
+	}
+	vector<IniReader::OverrideMap> configs;
+	string line;
+	while (getline(jobs, line))
+	{
+		size_t space = line.find(' ');
+		IniReader::OverrideMap *config = parseParamOverrides(space == string::npos ? "" : line.substr(space+1));
+		configs.push_back(*config);
+		delete config;
+	}
+
+	vector<GridResult> results(configs.size());
+	for (size_t i=0; i<configs.size(); i++)
+	{
+		GridResult &r = results[i];
+		ifstream resultFile((queueResultName(dir, i) + ".result").c_str());
+		r.done = (bool)(resultFile >> r.cycles >> r.reads >> r.writes >> r.bandwidth >> r.readLatency >> r.wallSeconds);
+	}
+	size_t pending = listDirectory(queuePath(dir, "pending")).size();
+	size_t running = listDirectory(queuePath(dir, "running")).size();
+	if (pending + running > 0)
+	{
+		cout << "== Note: "<<pending<<" jobs still pending and "<<running<<" running =="<<endl;
+	}
+	printGridTable(configs, &results[0], queuePath(dir, "results", "job"), queuePath(dir, "results.csv"));
+}
+
+/**
+ * Time-parallel simulation: the trace is cut into segments of whole epochs
+ * and every segment gets its own memory system and thread. A segment
+ * fast-forwards (functionally) to warmup cycles before its start, simulates
+ * the warm-up in detail without measuring, measures its own cycles and
+ * drains. Segment k-1 measures the cycles segment k uses as warm-up, which
+ * is how the divergence at each boundary is measured.
+ **/
+struct Segment
+{
+	MultiChannelMemorySystem *memorySystem;
+	const vector<TraceRecord> *records;
+	double rateScale;
+	uint64_t memorySize;
+	uint64_t start;
+	uint64_t end;
+	uint64_t warmup;
+	TransactionReceiver receiver;
+	uint64_t recordsFastForwarded;
+	double wallSeconds;
+};
+
+void *runSegment(void *arg)
+{
+	Segment &segment = *(Segment *)arg;
+	double startTime = wallClockSeconds();
+	TraceBuffer buffer(*segment.records);
+	TraceSource *source = &buffer;
+	if (segment.rateScale != 1.0)
+	{
+		source = new TraceTransform(&buffer, segment.rateScale, 0, segment.memorySize, false);
+	}
+	registerReceiver(segment.memorySystem, &segment.receiver);
+	segment.receiver.setBucketLength(EPOCH_LENGTH);
+	{
+		TraceDriver driver(segment.memorySystem, source, &segment.receiver);
+		uint64_t warmupStart = (segment.start > segment.warmup) ? segment.start - segment.warmup : 0;
+		// (fastForward(0) would mean "no limit")
+		segment.recordsFastForwarded = (warmupStart > 0) ? driver.fastForward(warmupStart) : 0;
+		segment.receiver.setMeasuring(false);
+		driver.run(segment.start - driver.currentClockCycle);
+		segment.receiver.setMeasuring(true);
+		driver.run(segment.end - driver.currentClockCycle);
+		segment.receiver.setMeasuring(false);
+		driver.drain();
+	}
+	if (source != &buffer)
+	{
+		delete source;
+	}
+	segment.wallSeconds = wallClockSeconds() - startTime;
+	return NULL;
+}
+
+// reads, writes and read latency summed over buckets [first, last)
+TransactionReceiver::BucketStats sumBuckets(const vector<TransactionReceiver::BucketStats> &buckets, size_t first, size_t last)
+{
+	TransactionReceiver::BucketStats sum = {0, 0, 0};
+	for (size_t i=first; i<last && i<buckets.size(); i++)
+	{
+		sum.reads += buckets[i].reads;
+		sum.writes += buckets[i].writes;
+		sum.totalReadLatency += buckets[i].totalReadLatency;
+	}
+	return sum;
+}
+
+double averageReadLatency(const TransactionReceiver::BucketStats &stats)
+{
+	return (stats.reads > 0) ? (double)stats.totalReadLatency / stats.reads * tCK : 0.0;
+}
+
+double relativeDifference(double value, double reference)
+{
+	return (reference != 0.0) ? 100.0 * (value - reference) / reference : 0.0;
+}
+
+int runSegments(unsigned numSegments, uint64_t warmup, uint64_t totalCycles, const vector<TraceRecord> &records,
+		double rateScale, const string &deviceIniFilename, const string &systemIniFilename, const string &pwdString,
+		const string &traceFileName, unsigned megsOfMemory, const IniReader::OverrideMap *paramOverrides)
+{
+	// the segments run side by side, so none of them gets a vis file
+	IniReader::OverrideMap overrides;
+	if (paramOverrides)
+	{
+		overrides = *paramOverrides;
+	}
+	overrides["VIS_FILE_OUTPUT"] = "false";
+
+	// the memory systems are built one after the other since reading the ini files sets globals
+	vector<Segment> segments(numSegments);
+	for (size_t k=0; k<numSegments; k++)
+	{
+		segments[k].memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory, NULL, &overrides);
+		segments[k].memorySystem->setCPUClockSpeed(0);
+	}
+	if (COMMAND_TRACE_OUTPUT || SAMPLE_INTERVAL > 0)
+	{
+		ERROR("COMMAND_TRACE_OUTPUT and SAMPLE_INTERVAL can't be combined with --segments: every segment would write the same files");
+		exit(-1);
+	}
+	uint64_t epochs = (totalCycles + EPOCH_LENGTH - 1) / EPOCH_LENGTH;
+	uint64_t segmentLength = ((epochs + numSegments - 1) / numSegments) * EPOCH_LENGTH;
+	warmup = ((max(warmup, (uint64_t)1) + EPOCH_LENGTH - 1) / EPOCH_LENGTH) * EPOCH_LENGTH;
+	for (size_t k=0; k<numSegments; k++)
+	{
+		Segment &segment = segments[k];
+		segment.records = &records;
+		segment.rateScale = rateScale;
+		segment.memorySize = ((uint64_t)TOTAL_STORAGE * NUM_CHANS) << 20;
+		segment.start = min(k * segmentLength, totalCycles);
+		segment.end = min((k+1) * segmentLength, totalCycles);
+		segment.warmup = warmup;
+	}
+
+	// the threads' own stats printing would interleave; only ours is wanted
+	int showSimOutput = SHOW_SIM_OUTPUT;
+	SHOW_SIM_OUTPUT = 0;
+	double startTime = wallClockSeconds();
+	vector<pthread_t> threads(numSegments);
+	for (size_t k=0; k<numSegments; k++)
+	{
+		if (pthread_create(&threads[k], NULL, runSegment, &segments[k]) != 0)
+		{
+			ERROR("Could not start the thread for segment "<<k);
+			exit(-1);
+		}
+	}
+	for (size_t k=0; k<numSegments; k++)
+	{
+		pthread_join(threads[k], NULL);
+	}
+	double wallSeconds = wallClockSeconds() - startTime;
+	SHOW_SIM_OUTPUT = showSimOutput;
+
+	cout << "== Time-parallel simulation: "<<numSegments<<" segments of "<<segmentLength<<" cycles with "<<warmup<<" cycles of warm-up, "
+		<< wallSeconds<<" s =="<<endl;
+	for (size_t k=0; k<numSegments; k++)
+	{
+		const Segment &segment = segments[k];
+		const TransactionReceiver &receiver = segment.receiver;
+		cout << "   Segment "<<k<<" : cycles ["<<segment.start<<","<<segment.end<<") "<<receiver.reads<<" reads, "<<receiver.writes
+			<< " writes, average read latency "<<((receiver.reads > 0) ? (double)receiver.totalReadLatency / receiver.reads * tCK : 0.0)
+			<< " ns ("<<segment.recordsFastForwarded<<" requests fast-forwarded, "<<segment.wallSeconds<<" s)"<<endl;
+	}
+
+	// the previous segment measured the cycles this one only used as warm-up
+	if (numSegments > 1)
+	{
+		cout << "== Divergence in the overlaps (warm-up of segment k vs. measurement of segment k-1) =="<<endl;
+	}
+	for (size_t k=1; k<numSegments; k++)
+	{
+		size_t first = (segments[k].start - min(segments[k].start, warmup)) / EPOCH_LENGTH;
+		size_t last = segments[k].start / EPOCH_LENGTH;
+		TransactionReceiver::BucketStats reference = sumBuckets(segments[k-1].receiver.buckets, first, last);
+		TransactionReceiver::BucketStats warm = sumBuckets(segments[k].receiver.buckets, first, last);
+		cout << "   Cycles ["<<first * EPOCH_LENGTH<<","<<last * EPOCH_LENGTH<<") : requests "<<warm.reads + warm.writes<<" vs "<<reference.reads + reference.writes
+			<< " ("<<relativeDifference(warm.reads + warm.writes, reference.reads + reference.writes)<<"%), average read latency "
+			<< averageReadLatency(warm)<<" vs "<<averageReadLatency(reference)<<" ns ("
+			<< relativeDifference(averageReadLatency(warm), averageReadLatency(reference))<<"%)"<<endl;
+	}
+
+	// every epoch comes from the segment that measured it
+	unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+	double epochSeconds = (double)EPOCH_LENGTH * tCK * 1E-9;
+	TransactionReceiver::BucketStats total = {0, 0, 0};
+	map<uint64_t, uint64_t> histogram;
+	cout << "== Stitched epochs =="<<endl;
+	cout << "         ms      reads     writes   GB/s   lat(ns)"<<endl;
+	for (uint64_t e=0; e<epochs; e++)
+	{
+		const Segment &owner = segments[min((size_t)(e * EPOCH_LENGTH / segmentLength), segments.size()-1)];
+		TransactionReceiver::BucketStats epoch = sumBuckets(owner.receiver.buckets, e, e+1);
+		cout << fixed << setprecision(3) << setw(11) << e * EPOCH_LENGTH * tCK * 1E-6 << setw(11) << epoch.reads << setw(11) << epoch.writes
+			<< setw(7) << (double)(epoch.reads + epoch.writes) * bytesPerTransaction / (1024.0*1024.0*1024.0) / epochSeconds
+			<< setw(10) << setprecision(2) << averageReadLatency(epoch) << endl;
+		cout.unsetf(ios::floatfield);
+		cout << setprecision(6);
+	}
+	for (size_t k=0; k<numSegments; k++)
+	{
+		const TransactionReceiver &receiver = segments[k].receiver;
+		total.reads += receiver.reads;
+		total.writes += receiver.writes;
+		total.totalReadLatency += receiver.totalReadLatency;
+		for (map<uint64_t, uint64_t>::const_iterator it=receiver.readLatencyHistogram.begin(); it!=receiver.readLatencyHistogram.end(); it++)
+		{
+			histogram[it->first] += it->second;
+		}
+		delete segments[k].memorySystem;
+	}
+	double seconds = (double)totalCycles * tCK * 1E-9;
+	cout << "== Stitched totals =="<<endl;
+	cout << "   Reads / Writes          : "<<total.reads<<" / "<<total.writes<<endl;
+	cout << "   Bandwidth               : "<<((seconds > 0) ? (double)(total.reads + total.writes) * bytesPerTransaction / (1024.0*1024.0*1024.0) / seconds : 0.0)<<" GB/s"<<endl;
+	cout << "   Average read latency    : "<<averageReadLatency(total)<<" ns"<<endl;
+	cout << "   Read latency histogram (cycles: count)"<<endl;
+	for (map<uint64_t, uint64_t>::const_iterator it=histogram.begin(); it!=histogram.end(); it++)
+	{
+		cout << "      ["<<it->first * HISTOGRAM_BIN_SIZE<<"-"<<(it->first+1) * HISTOGRAM_BIN_SIZE - 1<<"] : "<<it->second<<endl;
+	}
+	return 0;
+}
+
+/*
+ * Channel sharding: with open loop replay the channels only interact
+ * through the shared trace cursor, so a multi-channel run can be split into
+ * one process per channel. splitTrace() writes the records of each channel
+ * (by the configured address mapping) to directory/TRACENAME.chN, line for
+ * line as they are in the trace so the timestamps are kept; each shard is
+ * then run with --channel=N and shard_sim.py merges the outputs.
+ */
+void splitTrace(const string &traceFilename, TraceType traceType, bool useClockCycle, const string &directory)
+{
+	ifstream traceFile(traceFilename.c_str());
+	if (!traceFile.is_open())
+	{
+		ERROR("Could not open trace file '"<<traceFilename<<"'");
+		exit(-1);
+	}
+	makeDirectory(directory);
+	string shardName = directory + "/" + traceFilename.substr(traceFilename.find_last_of("/")+1);
+	vector<ofstream *> shards(NUM_CHANS);
+	vector<uint64_t> shardRecords(NUM_CHANS, 0);
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		stringstream name;
+		name << shardName << ".ch" << i;
+		shards[i] = new ofstream(name.str().c_str());
+		if (!shards[i]->is_open())
+		{
+			ERROR("Could not create trace shard '"<<name.str()<<"'");
+			exit(-1);
+		}
+	}
+
+	string line;
+	while (getline(traceFile, line))
+	{
+		if (line.size() == 0)
+		{
+			continue;
+		}
+		// parsing may change the line, so keep it as it was for the shard
+		string record(line);
+		Transaction trans(DATA_READ, 0, NULL);
+		uint64_t clockCycle = 0;
+		void *data = parseTraceFileLine(line, trans.address, trans.transactionType, clockCycle, traceType, useClockCycle);
+		free(data);
+		TraceDriver::alignTransactionAddress(trans);
+		unsigned channel, rank, bank, row, col;
+		addressMapping(trans.address, channel, rank, bank, row, col);
+		*shards[channel] << record << "\n";
+		shardRecords[channel]++;
+	}
+
+	cout << "== Split '"<<traceFilename<<"' into "<<NUM_CHANS<<" channel shards "<<shardName<<".ch* =="<<endl;
+	for (size_t i=0; i<NUM_CHANS; i++)
+	{
+		cout << "   Channel "<<i<<" : "<<shardRecords[i]<<" records"<<endl;
+		delete shards[i];
+	}
+}
+
+/**
+ * Sampled simulation: rather than reading the whole trace, use the index to
+ * jump to each window, simulate its warm-up prefix without measuring, then
+ * measure the window itself and let it drain. The memory system keeps
+ * running from window to window so there is no reinitialization cost.
+ **/
+void runWindows(MultiChannelMemorySystem *memorySystem, TraceReader &traceReader, TraceSource *traceSource, const TraceIndex &traceIndex, const WindowOptions &windows, unsigned maxOutstandingReads)
+{
+	TransactionReceiver receiver;
+	registerReceiver(memorySystem, &receiver);
+	// traceSource reads through traceReader (possibly transformed); seeking is done on the reader
+	TraceDriver driver(memorySystem, traceSource, &receiver);
+	driver.setClosedLoop(maxOutstandingReads);
+
+	unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+	uint64_t totalReads=0, totalWrites=0, totalReadLatency=0, totalCycles=0;
+	double sumBandwidth=0.0, sumSquaredBandwidth=0.0;
+	uint64_t numWindows=0;
+
+	for (uint64_t w=0; windows.count == 0 || w < windows.count; w++)
+	{
+		uint64_t start = windows.start + w*windows.period;
+		if (start >= traceIndex.numRecords || (w > 0 && windows.period == 0))
+		{
+			break;
+		}
+		uint64_t warmupStart = (start > windows.warmup) ? start - windows.warmup : 0;
+
+		if (!traceReader.seekToRecord(warmupStart, traceIndex))
+		{
+			ERROR("Could not seek to record "<<warmupStart<<" for window "<<w<<"; the trace is shorter than its index says, rebuild it with --build-index");
+			break;
+		}
+		driver.rebase();
+
+		receiver.setMeasuring(false);
+		driver.issue(start - warmupStart);
+		receiver.resetStats();
+		receiver.setMeasuring(true);
+		driver.issue(windows.length);
+		receiver.setMeasuring(false);
+		driver.drain();
+
+		uint64_t cycles = (receiver.lastDoneCycle > receiver.firstIssueCycle) ? receiver.lastDoneCycle - receiver.firstIssueCycle : 0;
+		double seconds = (double)cycles * tCK * 1E-9;
+		double bandwidth = (seconds > 0) ? ((double)(receiver.reads + receiver.writes) * bytesPerTransaction / (1024.0*1024.0*1024.0)) / seconds : 0.0;
+		double latency = (receiver.reads > 0) ? (double)receiver.totalReadLatency / receiver.reads * tCK : 0.0;
+		cout << "== Window "<<w<<" : records ["<<start<<","<<start+receiver.reads+receiver.writes<<") "
+			<< receiver.reads <<" reads, "<<receiver.writes<<" writes in "<<cycles<<" cycles, "
+			<< bandwidth << " GB/s, average read latency "<<latency<<" ns"<<endl;
+
+		totalReads += receiver.reads;
+		totalWrites += receiver.writes;
+		totalReadLatency += receiver.totalReadLatency;
+		totalCycles += cycles;
+		sumBandwidth += bandwidth;
+		sumSquaredBandwidth += bandwidth*bandwidth;
+		numWindows++;
+	}
+
+	if (numWindows == 0)
+	{
+		ERROR("No windows to simulate (window start is past the "<<traceIndex.numRecords<<" records in the trace)");
+		return;
+	}
+
+	double meanBandwidth = sumBandwidth / numWindows;
+	double stddevBandwidth = sqrt(max(0.0, sumSquaredBandwidth / numWindows - meanBandwidth*meanBandwidth));
+	double totalSeconds = (double)totalCycles * tCK * 1E-9;
+	cout << "== Aggregate over "<<numWindows<<" windows =="<<endl;
+	cout << "   Reads / Writes          : "<<totalReads<<" / "<<totalWrites<<endl;
+	cout << "   Measured cycles         : "<<totalCycles<<endl;
+	cout << "   Bandwidth (aggregate)   : "<<((totalSeconds > 0) ? ((double)(totalReads+totalWrites) * bytesPerTransaction / (1024.0*1024.0*1024.0)) / totalSeconds : 0.0)<<" GB/s"<<endl;
+	cout << "   Bandwidth (per window)  : "<<meanBandwidth<<" +/- "<<stddevBandwidth<<" GB/s"<<endl;
+	cout << "   Average read latency    : "<<((totalReads > 0) ? (double)totalReadLatency / totalReads * tCK : 0.0)<<" ns"<<endl;
+}
+
+/** 
+ * Override options can be specified on the command line as -o key1=value1,key2=value2
+ * this method should parse the key-value pairs and put them into a map 
+ **/ 
+IniReader::OverrideMap *parseParamOverrides(const string &kv_str)
+{
+	IniReader::OverrideMap *kv_map = new IniReader::OverrideMap(); 
+	size_t start = 0, comma=0, equal_sign=0;
+	// split the commas if they are there
+	while (1)
+	{
+		equal_sign = kv_str.find('=', start); 
+		if (equal_sign == string::npos)
+		{
+			break;
+		}
+
+		comma = kv_str.find(',', equal_sign);
+		if (comma == string::npos)
+		{
+			comma = kv_str.length();
+		}
+
+		string key = kv_str.substr(start, equal_sign-start);
+		string value = kv_str.substr(equal_sign+1, comma-equal_sign-1); 
+
+		(*kv_map)[key] = value; 
+		start = comma+1;
+
+	}
+	return kv_map; 
+}
+
+int main(int argc, char **argv)
+{
+	int c;
+	vector<string> traceFileNames;
+	vector<TraceType> traceTypes;
+	string traceFileName;
+	string systemIniFilename("system.ini");
+	string deviceIniFilename;
+	string pwdString;
+	string *visFilename = NULL;
+	unsigned megsOfMemory=2048;
+	bool useClockCycle=true;
+	
+	IniReader::OverrideMap *paramOverrides = NULL; 
+	IniReader::OverrideMap *generatorOptions = NULL;
+	string recordFilename;
+	string replayFilename;
+	string saveCheckpointFilename;
+	string restoreCheckpointFilename;
+	IniReader::OverrideMap *sweepGrid = NULL;
+	uint64_t sweepWarmup=0;
+	long sweepJobs=sysconf(_SC_NPROCESSORS_ONLN);
+	string sweepPrefix("sweep");
+	bool isSweepParent=false;
+	IniReader::OverrideMap *gridSpec = NULL;
+	string queueInitDir;
+	string queueWorkDir;
+	string queueMergeDir;
+	unsigned queueTimeout=60;
+	uint64_t fastForwardCycles=0;
+	uint64_t fastForwardRecords=0;
+	bool analyticalEngine=false;
+	string coefficientsFilename;
+	string calibrateFilename;
+	unsigned numSegments=0;
+	uint64_t segmentWarmup=0;
+	string splitDirectory;
+	int onlyChannel=-1;
+	double profileInterval=-1.0;
+
+	uint64_t indexInterval=0;
+	WindowOptions windows = {0, 0, 0, 0, 0};
+	unsigned maxOutstandingReads=0;
+	double rateScale=1.0;
+	unsigned replicas=1;
+	uint64_t replicaOffset=0;
+
+	uint64_t numCycles=1000;
+	bool numCyclesSet=false;
+	bool runToCompletion=false;
+	//getopt stuff
+	while (1)
+	{
+		static struct option long_options[] =
+		{
+			{"deviceini", required_argument, 0, 'd'},
+			{"tracefile", required_argument, 0, 't'},
+			{"systemini", required_argument, 0, 's'},
+
+			{"pwd", required_argument, 0, 'p'},
+			{"numcycles",  required_argument,	0, 'c'},
+			{"option",  required_argument,	0, 'o'},
+			{"quiet",  no_argument, &SHOW_SIM_OUTPUT, 'q'},
+			{"help", no_argument, 0, 'h'},
+			{"size", required_argument, 0, 'S'},
+			{"visfile", required_argument, 0, 'v'},
+			{"generate", required_argument, 0, 'g'},
+			{"build-index", optional_argument, 0, OPT_BUILD_INDEX},
+			{"window-start", required_argument, 0, OPT_WINDOW_START},
+			{"window-length", required_argument, 0, OPT_WINDOW_LENGTH},
+			{"window-period", required_argument, 0, OPT_WINDOW_PERIOD},
+			{"window-count", required_argument, 0, OPT_WINDOW_COUNT},
+			{"warmup", required_argument, 0, OPT_WARMUP},
+			{"closed-loop", required_argument, 0, OPT_CLOSED_LOOP},
+			{"rate-scale", required_argument, 0, OPT_RATE_SCALE},
+			{"replicate", required_argument, 0, OPT_REPLICATE},
+			{"replicate-offset", required_argument, 0, OPT_REPLICATE_OFFSET},
+			{"run-to-completion", no_argument, 0, OPT_RUN_TO_COMPLETION},
+			{"record", required_argument, 0, OPT_RECORD},
+			{"replay", required_argument, 0, OPT_REPLAY},
+			{"save-checkpoint", required_argument, 0, OPT_SAVE_CHECKPOINT},
+			{"restore-checkpoint", required_argument, 0, OPT_RESTORE_CHECKPOINT},
+			{"sweep", required_argument, 0, OPT_SWEEP},
+			{"sweep-warmup", required_argument, 0, OPT_SWEEP_WARMUP},
+			{"sweep-jobs", required_argument, 0, OPT_SWEEP_JOBS},
+			{"sweep-output", required_argument, 0, OPT_SWEEP_OUTPUT},
+			{"grid", required_argument, 0, OPT_GRID},
+			{"queue-init", required_argument, 0, OPT_QUEUE_INIT},
+			{"queue-work", required_argument, 0, OPT_QUEUE_WORK},
+			{"queue-timeout", required_argument, 0, OPT_QUEUE_TIMEOUT},
+			{"queue-merge", required_argument, 0, OPT_QUEUE_MERGE},
+			{"fast-forward", required_argument, 0, OPT_FAST_FORWARD},
+			{"fast-forward-records", required_argument, 0, OPT_FAST_FORWARD_RECORDS},
+			{"engine", required_argument, 0, OPT_ENGINE},
+			{"coefficients", required_argument, 0, OPT_COEFFICIENTS},
+			{"calibrate", required_argument, 0, OPT_CALIBRATE},
+			{"segments", required_argument, 0, OPT_SEGMENTS},
+			{"segment-warmup", required_argument, 0, OPT_SEGMENT_WARMUP},
+			{"split-trace", required_argument, 0, OPT_SPLIT_TRACE},
+			{"channel", required_argument, 0, OPT_CHANNEL},
+			{"profile", optional_argument, 0, OPT_PROFILE},
+			{0, 0, 0, 0}
+		};
+		int option_index=0; //for getopt
+		c = getopt_long (argc, argv, "t:s:c:d:o:p:S:v:g:qn", long_options, &option_index);
+		if (c == -1)
+		{
+			break;
+		}
 		switch (c)
 		{
 		case 0: //TODO: figure out what the hell this does, cuz it never seems to get called
@@ -426,7 +1306,8 @@ int main(int argc, char **argv)
 			exit(0);
 			break;
 		case 't':
-			traceFileName = string(optarg);
+			// every -t is another source; sourceIds follow the order given
+			traceFileNames.push_back(string(optarg));
 			break;
 		case 's':
 			systemIniFilename = string(optarg);
@@ -435,7 +1316,8 @@ int main(int argc, char **argv)
 			deviceIniFilename = string(optarg);
 			break;
 		case 'c':
-			numCycles = atoi(optarg);
+			numCycles = strtoull(optarg, NULL, 10);
+			numCyclesSet = true;
 			break;
 		case 'S':
 			megsOfMemory=atoi(optarg);
@@ -455,6 +1337,125 @@ int main(int argc, char **argv)
 		case 'v':
 			visFilename = new string(optarg);
 			break;
+		case 'g':
+			// same key=value,key=value syntax as the overrides
+			generatorOptions = parseParamOverrides(string(optarg));
+			break;
+		case OPT_BUILD_INDEX:
+			indexInterval = optarg ? strtoull(optarg, NULL, 10) : DEFAULT_INDEX_INTERVAL;
+			break;
+		case OPT_WINDOW_START:
+			windows.start = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_WINDOW_LENGTH:
+			windows.length = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_WINDOW_PERIOD:
+			windows.period = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_WINDOW_COUNT:
+			windows.count = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_WARMUP:
+			windows.warmup = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_CLOSED_LOOP:
+			maxOutstandingReads = atoi(optarg);
+			break;
+		case OPT_RATE_SCALE:
+			rateScale = atof(optarg);
+			break;
+		case OPT_REPLICATE:
+			replicas = atoi(optarg);
+			break;
+		case OPT_REPLICATE_OFFSET:
+			replicaOffset = strtoull(optarg, NULL, 0);
+			break;
+		case OPT_RUN_TO_COMPLETION:
+			runToCompletion = true;
+			break;
+		case OPT_RECORD:
+			recordFilename = string(optarg);
+			break;
+		case OPT_REPLAY:
+			replayFilename = string(optarg);
+			break;
+		case OPT_SAVE_CHECKPOINT:
+			saveCheckpointFilename = string(optarg);
+			break;
+		case OPT_RESTORE_CHECKPOINT:
+			restoreCheckpointFilename = string(optarg);
+			break;
+		case OPT_SWEEP:
+			sweepGrid = parseParamOverrides(string(optarg));
+			break;
+		case OPT_SWEEP_WARMUP:
+			sweepWarmup = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_SWEEP_JOBS:
+			sweepJobs = atol(optarg);
+			break;
+		case OPT_SWEEP_OUTPUT:
+			sweepPrefix = string(optarg);
+			break;
+		case OPT_GRID:
+			gridSpec = parseParamOverrides(string(optarg));
+			break;
+		case OPT_QUEUE_INIT:
+			queueInitDir = string(optarg);
+			break;
+		case OPT_QUEUE_WORK:
+			queueWorkDir = string(optarg);
+			break;
+		case OPT_QUEUE_TIMEOUT:
+			queueTimeout = atoi(optarg);
+			break;
+		case OPT_QUEUE_MERGE:
+			queueMergeDir = string(optarg);
+			break;
+		case OPT_FAST_FORWARD:
+			fastForwardCycles = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_FAST_FORWARD_RECORDS:
+			fastForwardRecords = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_ENGINE:
+			if (string(optarg) == "analytical")
+			{
+				analyticalEngine = true;
+			}
+			else if (string(optarg) != "detailed")
+			{
+				ERROR("Unknown engine '"<<optarg<<"'; use detailed or analytical");
+				exit(-1);
+			}
+			break;
+		case OPT_COEFFICIENTS:
+			coefficientsFilename = string(optarg);
+			break;
+		case OPT_CALIBRATE:
+			calibrateFilename = string(optarg);
+			break;
+		case OPT_SEGMENTS:
+			numSegments = atoi(optarg);
+			break;
+		case OPT_SEGMENT_WARMUP:
+			segmentWarmup = strtoull(optarg, NULL, 10);
+			break;
+		case OPT_SPLIT_TRACE:
+			splitDirectory = string(optarg);
+			break;
+		case OPT_CHANNEL:
+			onlyChannel = atoi(optarg);
+			break;
+		case OPT_PROFILE:
+			profileInterval = optarg ? atof(optarg) : DEFAULT_PROFILE_INTERVAL;
+			if (profileInterval < 0)
+			{
+				ERROR("--profile takes the number of seconds between progress reports, not '"<<optarg<<"'");
+				exit(-1);
+			}
+			break;
 		case '?':
 			usage();
 			exit(-1);
@@ -462,27 +1463,192 @@ int main(int argc, char **argv)
 		}
 	}
 
-	// get the trace filename
-	string temp = traceFileName.substr(traceFileName.find_last_of("/")+1);
+	if (windows.length > 0 && (saveCheckpointFilename.length() > 0 || restoreCheckpointFilename.length() > 0))
+	{
+		ERROR("Checkpoints can't be combined with sampled simulation");
+		exit(-1);
+	}
+
+	if ((fastForwardCycles > 0 || fastForwardRecords > 0) &&
+			(windows.length > 0 || replayFilename.length() > 0 || recordFilename.length() > 0))
+	{
+		ERROR("Fast-forward can't be combined with sampled simulation, --replay or --record");
+		exit(-1);
+	}
+
+	if (analyticalEngine && (calibrateFilename.length() > 0 || saveCheckpointFilename.length() > 0 || restoreCheckpointFilename.length() > 0))
+	{
+		ERROR("The analytical engine can't be calibrated against itself or checkpointed");
+		exit(-1);
+	}
+	if (calibrateFilename.length() > 0 && (saveCheckpointFilename.length() > 0 || sweepGrid))
+	{
+		ERROR("--calibrate can't be combined with --save-checkpoint or --sweep");
+		exit(-1);
+	}
+
+	// every memory system made in this process (or forked from it) records to the same file
+	char *recordEnv = getenv("DRAMSIM_RECORD");
+	bool recordingFromEnv = recordEnv != NULL && recordEnv[0] != '\0';
+
+	if (numSegments > 0)
+	{
+		if (traceFileNames.size() != 1 || replicas != 1 || generatorOptions || replayFilename.length() > 0 || windows.length > 0 ||
+				maxOutstandingReads > 0 || sweepGrid || gridSpec || queueWorkDir.length() > 0 || analyticalEngine ||
+				calibrateFilename.length() > 0 || recordFilename.length() > 0 || recordingFromEnv || fastForwardCycles > 0 || fastForwardRecords > 0 ||
+				saveCheckpointFilename.length() > 0 || restoreCheckpointFilename.length() > 0)
+		{
+			ERROR("--segments works on a single open loop tracefile (optionally with --rate-scale) and no other modes");
+			exit(-1);
+		}
+	}
+
+	// the profiler times the one simulation thread of a plain run
+	if (profileInterval >= 0 && (numSegments > 0 || windows.length > 0))
+	{
+		ERROR("--profile can't be combined with --segments or sampled simulation");
+		exit(-1);
+	}
+
+	if (splitDirectory.length() > 0 && (traceFileNames.size() != 1 || replicas != 1 || generatorOptions || replayFilename.length() > 0))
+	{
+		ERROR("--split-trace splits a single tracefile");
+		exit(-1);
+	}
+	if (onlyChannel >= 0 && (analyticalEngine || numSegments > 0 || maxOutstandingReads > 0 ||
+				saveCheckpointFilename.length() > 0 || restoreCheckpointFilename.length() > 0))
+	{
+		ERROR("--channel runs an open loop shard in detail; it can't be combined with closed loop replay, the analytical engine, --segments or checkpoints");
+		exit(-1);
+	}
+
+	vector<IniReader::OverrideMap> sweepVariants;
+	if (sweepGrid)
+	{
+		if (windows.length > 0 || saveCheckpointFilename.length() > 0)
+		{
+			ERROR("A sweep can't be combined with sampled simulation or --save-checkpoint");
+			exit(-1);
+		}
+		if (recordFilename.length() > 0 || recordingFromEnv)
+		{
+			ERROR("A sweep can't be combined with --record or DRAMSIM_RECORD: the variants would all write the same recording");
+			exit(-1);
+		}
+		for (IniReader::OverrideIterator it=sweepGrid->begin(); it!=sweepGrid->end(); it++)
+		{
+			if (!IniReader::IsRuntimeSafe(it->first))
+			{
+				ERROR("'"<<it->first<<"' can't be changed in a running simulation, so it can't be swept from a shared warm-up; use -o with separate runs instead");
+				exit(-1);
+			}
+		}
+		sweepVariants = expandSweepGrid(*sweepGrid);
+		delete sweepGrid;
+		if (sweepJobs < 1)
+		{
+			sweepJobs = 1;
+		}
+	}
+
+	// creating and merging a queue don't simulate anything
+	if (queueInitDir.length() > 0)
+	{
+		if (!gridSpec)
+		{
+			ERROR("--queue-init needs a --grid to fill the queue with");
+			exit(-1);
+		}
+		initJobQueue(queueInitDir, expandSweepGrid(*gridSpec));
+		return 0;
+	}
+	if (queueMergeDir.length() > 0)
+	{
+		mergeJobQueue(queueMergeDir);
+		return 0;
+	}
 
-	//get the prefix of the trace name
-	temp = temp.substr(0,temp.find_first_of("_"));
-	if (temp=="mase")
+	vector<IniReader::OverrideMap> gridConfigs;
+	if (queueWorkDir.length() > 0 && gridSpec)
 	{
-		traceType = mase;
+		ERROR("A queue worker takes its configurations from the queue, not from --grid");
+		exit(-1);
 	}
-	else if (temp=="k6")
+	if (gridSpec || queueWorkDir.length() > 0)
 	{
-		traceType = k6;
+		if (sweepGrid || windows.length > 0 || saveCheckpointFilename.length() > 0 || restoreCheckpointFilename.length() > 0 ||
+				recordFilename.length() > 0 || replayFilename.length() > 0 || generatorOptions)
+		{
+			ERROR("--grid and --queue-work run tracefiles from cycle 0; they can't be combined with --sweep, sampled simulation, checkpoints, --record, --replay or --generate");
+			exit(-1);
+		}
+		if (recordingFromEnv)
+		{
+			ERROR("--grid and --queue-work can't record with DRAMSIM_RECORD: the jobs would all write the same recording");
+			exit(-1);
+		}
+	}
+	if (gridSpec)
+	{
+		gridConfigs = expandSweepGrid(*gridSpec);
+		delete gridSpec;
+		if (sweepJobs < 1)
+		{
+			sweepJobs = 1;
+		}
+	}
+
+	if (replayFilename.length() > 0)
+	{
+		if (generatorOptions || traceFileNames.size() > 0 || windows.length > 0 || indexInterval > 0 ||
+				replicas != 1 || rateScale != 1.0 || maxOutstandingReads > 0)
+		{
+			ERROR("--replay reproduces a recording as is; it can't be combined with other traffic options");
+			exit(-1);
+		}
+		traceFileName = replayFilename;
 	}
-	else if (temp=="misc")
+	else if (generatorOptions)
 	{
-		traceType = misc;
+		if (windows.length > 0 || indexInterval > 0)
+		{
+			ERROR("Sampled simulation needs a tracefile; it can't be combined with --generate");
+			exit(-1);
+		}
+		if (traceFileNames.size() > 0)
+		{
+			ERROR("Use either tracefiles or --generate, not both");
+			exit(-1);
+		}
+		if (replicas != 1)
+		{
+			ERROR("--replicate only applies to tracefiles");
+			exit(-1);
+		}
+		// the vis file gets named after the pattern instead of a tracefile
+		traceFileName = TrafficGenerator::getName(*generatorOptions);
 	}
 	else
 	{
-		ERROR("== Unknown Tracefile Type : "<<temp);
-		exit(0);
+		if (traceFileNames.size() == 0)
+		{
+			ERROR("Please provide a tracefile");
+			usage();
+			exit(-1);
+		}
+		if ((traceFileNames.size() > 1 || replicas > 1) && (windows.length > 0 || indexInterval > 0))
+		{
+			ERROR("Sampled simulation only works on a single tracefile");
+			exit(-1);
+		}
+		traceTypes.resize(traceFileNames.size());
+		for (size_t i=0; i<traceFileNames.size(); i++)
+		{
+			if (!TraceReader::typeFromFilename(traceFileNames[i], traceTypes[i]))
+			{
+				exit(0);
+			}
+		}
 	}
 
 
@@ -495,120 +1661,334 @@ int main(int argc, char **argv)
 	}
 
 
-	//ignore the pwd argument if the argument is an absolute path
-	if (pwdString.length() > 0 && traceFileName[0] != '/')
+	for (size_t i=0; i<traceFileNames.size(); i++)
+	{
+		//ignore the pwd argument if the argument is an absolute path
+		if (pwdString.length() > 0 && traceFileNames[i][0] != '/')
+		{
+			traceFileNames[i] = pwdString + "/" +traceFileNames[i];
+		}
+		if (traceFileNames.size() > 1)
+		{
+			DEBUG("== Loading trace file '"<<traceFileNames[i]<<"' as source "<<i<<" == ");
+		}
+		else
+		{
+			DEBUG("== Loading trace file '"<<traceFileNames[i]<<"' == ");
+		}
+	}
+
+	if (replayFilename.length() > 0)
+	{
+		DEBUG("== Replaying request recording '"<<traceFileName<<"' == ");
+	}
+	else if (generatorOptions)
+	{
+		DEBUG("== Generating synthetic traffic '"<<traceFileName<<"' == ");
+	}
+	else if (traceFileNames.size() * replicas == 1)
+	{
+		traceFileName = traceFileNames[0];
+	}
+	else
 	{
-		traceFileName = pwdString + "/" +traceFileName;
+		// name the results after the first trace and how many there are
+		stringstream name;
+		name << traceFileNames[0] << ".x" << traceFileNames.size() * replicas;
+		traceFileName = name.str();
 	}
 
-	DEBUG("== Loading trace file '"<<traceFileName<<"' == ");
+	if (splitDirectory.length() > 0)
+	{
+		// the address mapping comes from the ini files, which the memory system reads in
+		MultiChannelMemorySystem memorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory, NULL, paramOverrides);
+		delete paramOverrides;
+		splitTrace(traceFileNames[0], traceTypes[0], useClockCycle, splitDirectory);
+		return 0;
+	}
 
-	ifstream traceFile;
-	string line;
+	if (numSegments > 0)
+	{
+		vector<TraceRecord> records;
+		TraceReader reader(traceFileNames[0], traceTypes[0], useClockCycle);
+		TraceBuffer::load(reader, records);
+		// run to completion covers the whole trace; the last segment drains it
+		uint64_t totalCycles = numCycles;
+		if (runToCompletion && records.size() > 0)
+		{
+			totalCycles = (uint64_t)(records.back().clockCycle / rateScale) + 1;
+		}
+		int result = runSegments(numSegments, segmentWarmup, totalCycles, records, rateScale, deviceIniFilename, systemIniFilename,
+				pwdString, traceFileName, megsOfMemory, paramOverrides);
+		delete paramOverrides;
+		return result;
+	}
 
+	/*
+	 * A grid or queue worker reads every trace into memory once and then
+	 * forks a job per configuration; each job builds its own memory system
+	 * from the ini files plus its overrides, replays its copy-on-write copy
+	 * of the records and fills in jobResult.
+	 */
+	vector<vector<TraceRecord> > preloadedTraces;
+	GridResult *jobResult = NULL;
+	double jobStartTime = 0.0;
+	if (gridConfigs.size() > 0 || queueWorkDir.length() > 0)
+	{
+		preloadedTraces.resize(traceFileNames.size());
+		for (size_t i=0; i<traceFileNames.size(); i++)
+		{
+			TraceReader reader(traceFileNames[i], traceTypes[i], useClockCycle);
+			TraceBuffer::load(reader, preloadedTraces[i]);
+		}
+	}
+	if (gridConfigs.size() > 0)
+	{
+		GridResult *gridResults = mapGridResults(gridConfigs.size());
+		vector<size_t> failed;
+		int gridJob = forkGridJobs(gridConfigs, sweepJobs, failed);
+		if (gridJob < 0)
+		{
+			printGridTable(gridConfigs, gridResults, sweepPrefix, sweepPrefix + ".csv");
+			munmap(gridResults, gridConfigs.size() * sizeof(GridResult));
+			return failed.empty() ? 0 : 1;
+		}
+		jobStartTime = wallClockSeconds();
+		jobResult = &gridResults[gridJob];
+		stringstream resultName;
+		resultName << sweepPrefix << "." << gridJob;
+		setUpJob(resultName.str(), gridConfigs[gridJob], paramOverrides, visFilename);
+	}
+	else if (queueWorkDir.length() > 0)
+	{
+		GridResult *queueResult = mapGridResults(1);
+		IniReader::OverrideMap config;
+		int queueJob = runQueueWorker(queueWorkDir, queueTimeout, queueResult, config);
+		if (queueJob < 0)
+		{
+			cout << "== Job queue '"<<queueWorkDir<<"' is empty =="<<endl;
+			munmap(queueResult, sizeof(GridResult));
+			return 0;
+		}
+		jobStartTime = wallClockSeconds();
+		jobResult = queueResult;
+		setUpJob(queueResultName(queueWorkDir, queueJob), config, paramOverrides, visFilename);
+	}
 
 	MultiChannelMemorySystem *memorySystem = new MultiChannelMemorySystem(deviceIniFilename, systemIniFilename, pwdString, traceFileName, megsOfMemory, visFilename, paramOverrides);
 	// set the frequency ratio to 1:1
 	memorySystem->setCPUClockSpeed(0); 
-	std::ostream &dramsim_logfile = memorySystem->getLogFile(); 
 	// don't need this anymore 
 	delete paramOverrides;
+	if (analyticalEngine)
+	{
+		memorySystem->useAnalyticalModel(coefficientsFilename);
+	}
+	else if (calibrateFilename.length() > 0)
+	{
+		memorySystem->startCalibration();
+	}
+	if (onlyChannel >= 0)
+	{
+		memorySystem->simulateOnlyChannel(onlyChannel);
+	}
 
-
-#ifdef RETURN_TRANSACTIONS
-	TransactionReceiver transactionReceiver; 
-	/* create and register our callback functions */
-	Callback_t *read_cb = new Callback<TransactionReceiver, void, unsigned, uint64_t, uint64_t>(&transactionReceiver, &TransactionReceiver::read_complete);
-	Callback_t *write_cb = new Callback<TransactionReceiver, void, unsigned, uint64_t, uint64_t>(&transactionReceiver, &TransactionReceiver::write_complete);
-	memorySystem->RegisterCallbacks(read_cb, write_cb, NULL);
-#endif
-
-
-	uint64_t addr;
-	uint64_t clockCycle=0;
-	enum TransactionType transType;
-
-	void *data = NULL;
-	int lineNumber = 0;
-	Transaction *trans=NULL;
-	bool pendingTrans = false;
-
-	traceFile.open(traceFileName.c_str());
-
-	if (!traceFile.is_open())
+	if (recordFilename.length() > 0)
 	{
-		cout << "== Error - Could not open trace file"<<endl;
-		exit(0);
+		memorySystem->startRecording(recordFilename);
 	}
 
-	for (size_t i=0;i<numCycles;i++)
+	vector<TraceSource *> traceSources;
+	RequestReplayReader *replayReader = NULL;
+	TraceReader *traceReader = NULL;
+	uint64_t memorySize = ((uint64_t)TOTAL_STORAGE * NUM_CHANS) << 20;
+	if (replicas == 0)
 	{
-		if (!pendingTrans)
+		replicas = 1;
+	}
+	if (replicaOffset == 0)
+	{
+		replicaOffset = memorySize / replicas;
+	}
+	if (replayFilename.length() > 0)
+	{
+		// the recording's cycles are CPU cycles, so run at the ratio it was made with
+		replayReader = new RequestReplayReader(replayFilename);
+		traceSources.push_back(replayReader);
+		memorySystem->setCPUClockSpeed(replayReader->cpuClockHz);
+	}
+	else if (generatorOptions)
+	{
+		// the generator needs the address mapping, so it can only be built once the ini files are loaded
+		traceSources.push_back(new TrafficGenerator(*generatorOptions, useClockCycle));
+		delete generatorOptions;
+		if (rateScale != 1.0)
+		{
+			traceSources[0] = new TraceTransform(traceSources[0], rateScale, 0, memorySize);
+		}
+	}
+	else
+	{
+		// sourceId = trace * replicas + copy; every copy reads its file independently
+		for (size_t i=0; i<traceFileNames.size(); i++)
 		{
-			if (!traceFile.eof())
+			for (unsigned r=0; r<replicas; r++)
 			{
-				getline(traceFile, line);
-
-				if (line.size() > 0)
+				TraceSource *source;
+				if (jobResult)
 				{
-					data = parseTraceFileLine(line, addr, transType,clockCycle, traceType,useClockCycle);
-					trans = new Transaction(transType, addr, data);
-					alignTransactionAddress(*trans); 
-
-					if (i>=clockCycle)
-					{
-						if (!(*memorySystem).addTransaction(trans))
-						{
-							pendingTrans = true;
-						}
-						else
-						{
-#ifdef RETURN_TRANSACTIONS
-							transactionReceiver.add_pending(trans, i); 
-#endif
-							// the memory system accepted our request so now it takes ownership of it
-							trans = NULL; 
-						}
-					}
-					else
-					{
-						pendingTrans = true;
-					}
+					source = new TraceBuffer(preloadedTraces[i]);
 				}
 				else
 				{
-					DEBUG("WARNING: Skipping line "<<lineNumber<< " ('" << line << "') in tracefile");
+					source = traceReader = new TraceReader(traceFileNames[i], traceTypes[i], useClockCycle);
+				}
+				if (rateScale != 1.0 || r > 0)
+				{
+					traceSources.push_back(new TraceTransform(source, rateScale, r * replicaOffset, memorySize));
+				}
+				else
+				{
+					traceSources.push_back(source);
 				}
-				lineNumber++;
-			}
-			else
-			{
-				//we're out of trace, set pending=false and let the thing spin without adding transactions
-				pendingTrans = false; 
 			}
 		}
+	}
 
-		else if (pendingTrans && i >= clockCycle)
+	TraceIndex traceIndex;
+	if (indexInterval > 0 || windows.length > 0)
+	{
+		string indexFilename = TraceIndex::sidecarFilename(traceFileName);
+		if (indexInterval > 0 || !traceIndex.load(indexFilename, traceFileName))
 		{
-			pendingTrans = !(*memorySystem).addTransaction(trans);
-			if (!pendingTrans)
+			if (indexInterval == 0)
 			{
+				indexInterval = DEFAULT_INDEX_INTERVAL;
+			}
+			cerr << "== Indexing '"<<traceFileName<<"' every "<<indexInterval<<" records == "<<endl;
+			traceIndex.build(*traceReader, indexInterval);
+			traceIndex.save(indexFilename);
+			cerr << "== Wrote "<<traceIndex.offsets.size()<<" index entries ("<<traceIndex.numRecords<<" records) to '"<<indexFilename<<"' == "<<endl;
+		}
+	}
+
+	if (windows.length > 0)
+	{
+		runWindows(memorySystem, *traceReader, traceSources[0], traceIndex, windows, maxOutstandingReads);
+	}
+	else
+	{
+		TransactionReceiver *transactionReceiver = NULL;
 #ifdef RETURN_TRANSACTIONS
-				transactionReceiver.add_pending(trans, i); 
+		transactionReceiver = new TransactionReceiver();
+#else
+		// closed loop needs the completions to know when reads come back and
+		// per source stats need them to know whose request finished and a
+		// grid or queue job reports its latency and bandwidth from them
+		if (maxOutstandingReads > 0 || traceSources.size() > 1 || jobResult)
+		{
+			transactionReceiver = new TransactionReceiver();
+		}
 #endif
-				trans=NULL;
+		if (transactionReceiver)
+		{
+			registerReceiver(memorySystem, transactionReceiver);
+		}
+		TraceDriver driver(memorySystem, traceSources, transactionReceiver);
+		driver.setClosedLoop(maxOutstandingReads);
+		driver.setExactReplay(replayReader != NULL);
+		if (restoreCheckpointFilename.length() > 0)
+		{
+			restoreCheckpoint(restoreCheckpointFilename, memorySystem, driver, transactionReceiver);
+		}
+		if (fastForwardCycles > 0 || fastForwardRecords > 0)
+		{
+			double start = wallClockSeconds();
+			uint64_t applied = driver.fastForward(fastForwardCycles, fastForwardRecords);
+			cout << "== Fast-forwarded "<<applied<<" requests to cycle "<<driver.currentClockCycle
+				<< " in "<<wallClockSeconds() - start<<" s =="<<endl;
+		}
+		if (profileInterval >= 0)
+		{
+			Profiler::start(profileInterval, (numCyclesSet || !runToCompletion) ? numCycles : 0, driver.currentClockCycle, driver.recordsIssued);
+		}
+		if (sweepVariants.size() > 0)
+		{
+			if (sweepWarmup > driver.currentClockCycle)
+			{
+				driver.run(sweepWarmup - driver.currentClockCycle);
+			}
+			isSweepParent = runSweep(memorySystem, traceSources, driver.currentClockCycle, sweepVariants, sweepJobs, sweepPrefix);
+			if (!isSweepParent && transactionReceiver)
+			{
+				transactionReceiver->resetStats();
 			}
 		}
-
-		(*memorySystem).update();
+		if (isSweepParent)
+		{
+			// the variants report their own results
+		}
+		else if (runToCompletion)
+		{
+			if (driver.runToCompletion(numCyclesSet ? numCycles : 0))
+			{
+				cout << "== Completed "<<driver.recordsIssued<<" requests at cycle "<<driver.currentClockCycle
+					<< " ("<<driver.currentClockCycle * tCK<<" ns) =="<<endl;
+			}
+			else
+			{
+				cout << "== Stopped at the "<<numCycles<<" cycle limit before completing ("<<driver.recordsIssued<<" requests issued) =="<<endl;
+			}
+		}
+		else if (numCycles > driver.currentClockCycle)
+		{
+			driver.run(numCycles - driver.currentClockCycle);
+		}
+		if (profileInterval >= 0 && !isSweepParent)
+		{
+			Profiler::printSummary(cerr, driver.currentClockCycle, driver.recordsIssued);
+		}
+		if (saveCheckpointFilename.length() > 0)
+		{
+			saveCheckpoint(saveCheckpointFilename, memorySystem, driver, transactionReceiver);
+		}
+		if (maxOutstandingReads > 0 && !isSweepParent)
+		{
+			cout << "== Closed loop ("<<maxOutstandingReads<<" outstanding reads): "<<driver.recordsIssued<<" requests issued, "
+				<< driver.windowStallCycles<<" cycles stalled on a full window, average read latency "
+				<< ((transactionReceiver->reads > 0) ? (double)transactionReceiver->totalReadLatency / transactionReceiver->reads * tCK : 0.0)<<" ns"<<endl;
+		}
+		if (traceSources.size() > 1 && !isSweepParent)
+		{
+			transactionReceiver->printSourceStats(cout);
+		}
+		if (jobResult)
+		{
+			GridResult &result = *jobResult;
+			double seconds = (double)driver.currentClockCycle * tCK * 1E-9;
+			unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS*BL)/8;
+			result.cycles = driver.currentClockCycle;
+			result.reads = transactionReceiver->reads;
+			result.writes = transactionReceiver->writes;
+			result.bandwidth = (seconds > 0) ? ((double)(result.reads + result.writes) * bytesPerTransaction / (1024.0*1024.0*1024.0)) / seconds : 0.0;
+			result.readLatency = (result.reads > 0) ? (double)transactionReceiver->totalReadLatency / result.reads * tCK : 0.0;
+			result.wallSeconds = wallClockSeconds() - jobStartTime;
+			result.done = true;
+		}
+		delete transactionReceiver;
 	}
 
-	traceFile.close();
-	memorySystem->printStats(true);
-	// make valgrind happy
-	if (trans)
+	for (size_t i=0; i<traceSources.size(); i++)
+	{
+		delete traceSources[i];
+	}
+	if (!isSweepParent)
+	{
+		memorySystem->printStats(true);
+	}
+	if (calibrateFilename.length() > 0)
 	{
-		delete trans;
+		memorySystem->finishCalibration(calibrateFilename);
 	}
 	delete(memorySystem);
 }
@@ -0,0 +1,480 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TraceDriver.cpp
+//
+//Class file for the object that feeds trace records into a memory system
+//
+
+#include "TraceDriver.h"
+#include "Profiler.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+TraceDriver::TraceDriver(MultiChannelMemorySystem *memorySystem_, TraceSource *source, TransactionReceiver *receiver_) :
+	recordsIssued(0),
+	windowStallCycles(0),
+	memorySystem(memorySystem_),
+	receiver(receiver_),
+	numPending(0),
+	issuing(true),
+	maxOutstandingReads(0),
+	exactReplay(false)
+{
+	init(vector<TraceSource *>(1, source));
+}
+
+TraceDriver::TraceDriver(MultiChannelMemorySystem *memorySystem_, const vector<TraceSource *> &sources, TransactionReceiver *receiver_) :
+	recordsIssued(0),
+	windowStallCycles(0),
+	memorySystem(memorySystem_),
+	receiver(receiver_),
+	numPending(0),
+	issuing(true),
+	maxOutstandingReads(0),
+	exactReplay(false)
+{
+	init(sources);
+}
+
+void TraceDriver::init(const vector<TraceSource *> &sources)
+{
+	currentClockCycle = 0;
+	streams.resize(sources.size());
+	for (size_t i=0; i<sources.size(); i++)
+	{
+		Stream &stream = streams[i];
+		stream.source = sources[i];
+		stream.pendingTrans = NULL;
+		stream.pendingCycle = 0;
+		stream.pendingQueueIfFull = false;
+		stream.exhausted = false;
+		stream.recordsRead = 0;
+		stream.rebasePending = false;
+		stream.traceBase = 0;
+		stream.cycleBase = 0;
+		idleStreams.push_back(i);
+	}
+}
+
+TraceDriver::~TraceDriver()
+{
+	// make valgrind happy
+	for (size_t i=0; i<streams.size(); i++)
+	{
+		delete streams[i].pendingTrans;
+	}
+}
+
+void TraceDriver::alignTransactionAddress(Transaction &trans)
+{
+	// zero out the low order bits which correspond to the size of a transaction
+
+	unsigned throwAwayBits = dramsim_log2((BL*JEDEC_DATA_BUS_BITS/8));
+
+	trans.address >>= throwAwayBits;
+	trans.address <<= throwAwayBits;
+}
+
+//turns the next record of a stream into its pending request
+bool TraceDriver::fetch(unsigned streamId)
+{
+	Stream &stream = streams[streamId];
+	if (stream.buffer.empty())
+	{
+		TraceRecord record;
+		while (stream.buffer.size() < STREAM_BUFFER_RECORDS && stream.source->next(record))
+		{
+			stream.buffer.push_back(record);
+			stream.recordsRead++;
+		}
+		if (stream.buffer.empty())
+		{
+			//we're out of trace, let the thing spin without adding transactions
+			stream.exhausted = true;
+			return false;
+		}
+	}
+
+	const TraceRecord &record = stream.buffer.front();
+	if (stream.rebasePending)
+	{
+		stream.traceBase = record.clockCycle;
+		stream.cycleBase = currentClockCycle;
+		stream.rebasePending = false;
+	}
+	stream.pendingTrans = new Transaction(record.transactionType, record.address, record.data);
+	stream.pendingTrans->sourceId = streamId;
+	stream.pendingQueueIfFull = record.queueIfFull;
+	if (!exactReplay)
+	{
+		alignTransactionAddress(*stream.pendingTrans);
+	}
+	stream.pendingCycle = (record.clockCycle >= stream.traceBase) ? record.clockCycle - stream.traceBase + stream.cycleBase : stream.cycleBase;
+	stream.buffer.pop_front();
+
+	heads.push(StreamHead(stream.pendingCycle, streamId));
+	numPending++;
+	return true;
+}
+
+void TraceDriver::update()
+{
+	if (issuing)
+	{
+		vector<unsigned> stillIdle;
+		for (size_t i=0; i<idleStreams.size(); i++)
+		{
+			unsigned streamId = idleStreams[i];
+			if (!streams[streamId].exhausted && !fetch(streamId))
+			{
+				stillIdle.push_back(streamId);
+			}
+		}
+		idleStreams.swap(stillIdle);
+	}
+
+	// streams that couldn't issue this cycle go back on the heap afterwards so
+	// each stream gets at most one try per cycle
+	vector<unsigned> blocked;
+	while (!heads.empty() && heads.top().first <= currentClockCycle)
+	{
+		unsigned streamId = heads.top().second;
+		heads.pop();
+		Stream &stream = streams[streamId];
+
+		if (maxOutstandingReads > 0 && stream.pendingTrans->transactionType == DATA_READ &&
+				receiver->getOutstandingReads(streamId) >= maxOutstandingReads)
+		{
+			windowStallCycles++;
+			blocked.push_back(streamId);
+			continue;
+		}
+
+		// hang on to these since the memory system owns the transaction once it's accepted
+		TransactionType type = stream.pendingTrans->transactionType;
+		uint64_t address = stream.pendingTrans->address;
+		bool accepted;
+		if (stream.pendingQueueIfFull)
+		{
+			// this overload makes its own transaction
+			accepted = memorySystem->addTransaction(type == DATA_WRITE, address);
+			if (accepted)
+			{
+				delete stream.pendingTrans;
+			}
+		}
+		else
+		{
+			accepted = memorySystem->addTransaction(stream.pendingTrans);
+		}
+		if (accepted)
+		{
+			if (receiver)
+			{
+				// completions come back in memory system cycles
+				receiver->add_pending(type, address, memorySystem->currentClockCycle, streamId);
+			}
+			// closed loop: whatever held this request up holds up everything behind it too
+			if (maxOutstandingReads > 0)
+			{
+				stream.cycleBase += currentClockCycle - stream.pendingCycle;
+			}
+			stream.pendingTrans = NULL;
+			numPending--;
+			recordsIssued++;
+			// in an exact replay the next request may be due this very cycle
+			if (!(exactReplay && issuing && fetch(streamId)))
+			{
+				idleStreams.push_back(streamId);
+			}
+		}
+		else
+		{
+			blocked.push_back(streamId);
+		}
+	}
+	for (size_t i=0; i<blocked.size(); i++)
+	{
+		heads.push(StreamHead(streams[blocked[i]].pendingCycle, blocked[i]));
+	}
+
+	memorySystem->update();
+	step();
+	if (Profiler::enabled && (currentClockCycle & Profiler::PROGRESS_CHECK_MASK) == 0)
+	{
+		Profiler::progress(currentClockCycle, recordsIssued);
+	}
+}
+
+void TraceDriver::run(uint64_t numCycles)
+{
+	for (uint64_t i=0; i<numCycles; i++)
+	{
+		update();
+	}
+}
+
+/*
+ * Runs until every source is out of records and the memory system has
+ * nothing left in flight. Gives up after maxCycles (0 for no limit) and
+ * returns whether everything completed; currentClockCycle is the cycle the
+ * last request finished on.
+ */
+bool TraceDriver::runToCompletion(uint64_t maxCycles)
+{
+	while (!(isExhausted() && memorySystem->isDrained()))
+	{
+		if (maxCycles > 0 && currentClockCycle >= maxCycles)
+		{
+			return false;
+		}
+		update();
+	}
+	return true;
+}
+
+//runs until numRecords more records have made it into the memory system
+bool TraceDriver::issue(uint64_t numRecords)
+{
+	uint64_t target = recordsIssued + numRecords;
+	while (recordsIssued < target)
+	{
+		if (isExhausted())
+		{
+			return false;
+		}
+		update();
+	}
+	return true;
+}
+
+//runs until everything that was handed to the memory system has come back
+void TraceDriver::drain()
+{
+	if (!receiver)
+	{
+		ERROR("Can't tell when the memory system is drained without a TransactionReceiver");
+		abort();
+	}
+	issuing = false;
+	while (receiver->getOutstanding() > 0)
+	{
+		update();
+	}
+	issuing = true;
+}
+
+//the next record read from each stream will be issued relative to the
+//current cycle; anything read ahead before this is thrown away since the
+//sources are expected to have been repositioned
+void TraceDriver::rebase()
+{
+	for (size_t i=0; i<streams.size(); i++)
+	{
+		Stream &stream = streams[i];
+		stream.buffer.clear();
+		stream.rebasePending = true;
+		stream.exhausted = false;
+	}
+}
+
+/*
+ * Applies records functionally until the one due at untilCycle or until
+ * maxRecords of them have been applied, whichever comes first (0 for no
+ * limit), and leaves the clock where detailed simulation should carry on.
+ * Returns the number of records applied; they don't count as issued.
+ */
+uint64_t TraceDriver::fastForward(uint64_t untilCycle, uint64_t maxRecords)
+{
+	uint64_t applied = 0;
+	for (size_t i=0; i<idleStreams.size(); i++)
+	{
+		fetch(idleStreams[i]);
+	}
+	idleStreams.clear();
+
+	while (!heads.empty() && (untilCycle == 0 || heads.top().first < untilCycle) && (maxRecords == 0 || applied < maxRecords))
+	{
+		unsigned streamId = heads.top().second;
+		heads.pop();
+		Stream &stream = streams[streamId];
+		if (stream.pendingCycle > currentClockCycle)
+		{
+			memorySystem->fastForward(stream.pendingCycle - currentClockCycle);
+			currentClockCycle = stream.pendingCycle;
+		}
+		memorySystem->functionalAccess(stream.pendingTrans->address);
+		delete stream.pendingTrans;
+		stream.pendingTrans = NULL;
+		numPending--;
+		applied++;
+		if (!fetch(streamId))
+		{
+			idleStreams.push_back(streamId);
+		}
+	}
+
+	// stopped by the cycle (or ran out of records) rather than the count
+	if ((maxRecords == 0 || applied < maxRecords) && untilCycle > currentClockCycle)
+	{
+		memorySystem->fastForward(untilCycle - currentClockCycle);
+		currentClockCycle = untilCycle;
+	}
+	return applied;
+}
+
+bool TraceDriver::isExhausted() const
+{
+	if (numPending > 0)
+	{
+		return false;
+	}
+	for (size_t i=0; i<streams.size(); i++)
+	{
+		if (!streams[i].exhausted)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void TraceDriver::setClosedLoop(unsigned maxOutstandingReads_)
+{
+	if (maxOutstandingReads_ > 0 && !receiver)
+	{
+		ERROR("Closed loop replay needs a TransactionReceiver to count outstanding reads");
+		abort();
+	}
+	maxOutstandingReads = maxOutstandingReads_;
+}
+
+void TraceDriver::setExactReplay(bool exactReplay_)
+{
+	exactReplay = exactReplay_;
+}
+
+void TraceDriver::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_TRACE_DRIVER);
+	checkpoint.write(currentClockCycle);
+	checkpoint.write(recordsIssued);
+	checkpoint.write(windowStallCycles);
+	checkpoint.write<uint64_t>(streams.size());
+	for (size_t i=0; i<streams.size(); i++)
+	{
+		const Stream &stream = streams[i];
+		checkpoint.write(stream.recordsRead);
+		checkpoint.write<uint64_t>(stream.buffer.size());
+		for (size_t j=0; j<stream.buffer.size(); j++)
+		{
+			checkpoint.write(stream.buffer[j].address);
+			checkpoint.write(stream.buffer[j].transactionType);
+			checkpoint.write(stream.buffer[j].clockCycle);
+			checkpoint.write(stream.buffer[j].queueIfFull);
+		}
+		checkpoint.writeTransaction(stream.pendingTrans);
+		checkpoint.write(stream.pendingCycle);
+		checkpoint.write(stream.pendingQueueIfFull);
+		checkpoint.write(stream.exhausted);
+		checkpoint.write(stream.rebasePending);
+		checkpoint.write(stream.traceBase);
+		checkpoint.write(stream.cycleBase);
+	}
+	checkpoint.writeVector(idleStreams);
+}
+
+void TraceDriver::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readSection(CHECKPOINT_TRACE_DRIVER);
+	checkpoint.read(currentClockCycle);
+	checkpoint.read(recordsIssued);
+	checkpoint.read(windowStallCycles);
+	uint64_t numStreams;
+	checkpoint.read(numStreams);
+	if (numStreams != streams.size())
+	{
+		ERROR("Checkpoint '"<<checkpoint.filename<<"' was saved with "<<numStreams<<" sources, not "<<streams.size());
+		exit(-1);
+	}
+
+	while (!heads.empty())
+	{
+		heads.pop();
+	}
+	numPending = 0;
+	for (size_t i=0; i<streams.size(); i++)
+	{
+		Stream &stream = streams[i];
+		uint64_t recordsRead;
+		checkpoint.read(recordsRead);
+		TraceRecord record;
+		for (; stream.recordsRead < recordsRead; stream.recordsRead++)
+		{
+			if (!stream.source->next(record))
+			{
+				ERROR("Source "<<i<<" ran out after "<<stream.recordsRead<<" records while restoring a checkpoint that had read "<<recordsRead);
+				exit(-1);
+			}
+		}
+
+		uint64_t size;
+		checkpoint.read(size);
+		stream.buffer.resize(size);
+		for (size_t j=0; j<size; j++)
+		{
+			checkpoint.read(stream.buffer[j].address);
+			checkpoint.read(stream.buffer[j].transactionType);
+			checkpoint.read(stream.buffer[j].clockCycle);
+			checkpoint.read(stream.buffer[j].queueIfFull);
+			stream.buffer[j].data = NULL;
+		}
+		delete stream.pendingTrans;
+		stream.pendingTrans = checkpoint.readTransaction();
+		checkpoint.read(stream.pendingCycle);
+		checkpoint.read(stream.pendingQueueIfFull);
+		checkpoint.read(stream.exhausted);
+		checkpoint.read(stream.rebasePending);
+		checkpoint.read(stream.traceBase);
+		checkpoint.read(stream.cycleBase);
+
+		// between cycles the heap holds exactly the streams with a pending request
+		if (stream.pendingTrans)
+		{
+			heads.push(StreamHead(stream.pendingCycle, i));
+			numPending++;
+		}
+	}
+	checkpoint.readVector(idleStreams);
+}
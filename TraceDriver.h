@@ -0,0 +1,156 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRACEDRIVER_H
+#define TRACEDRIVER_H
+
+//TraceDriver.h
+//
+//Header file for the object that feeds trace records into a memory system
+//
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <functional>
+#include "SimulatorObject.h"
+#include "MultiChannelMemorySystem.h"
+#include "TraceReader.h"
+#include "TransactionReceiver.h"
+#include "Checkpoint.h"
+
+using std::vector;
+using std::deque;
+using std::priority_queue;
+using std::pair;
+
+namespace DRAMSim
+{
+/*
+ * TraceDriver: pulls records out of one or more TraceSources and adds them to
+ * the memory system once their clock cycle comes up. Each update() is one CPU
+ * cycle: every source (stream) gets a chance to add at most one request and
+ * then the memory system is updated.
+ *
+ * With several streams the heads of all streams sit in a min-heap keyed on
+ * the cycle they are due, so each cycle only looks at the streams that have
+ * something to issue (a k-way merge by timestamp). Stream i tags its
+ * requests with sourceId i.
+ *
+ * By default the replay is open loop: a request goes out at its timestamp no
+ * matter how many reads are still in flight. setClosedLoop(N) caps the number
+ * of outstanding reads per stream at N; a read that finds its window full
+ * waits for a completion, and any time a request spends waiting pushes back
+ * every later request of that stream as well, so the gaps between requests
+ * are kept relative to when the memory system actually let the stream
+ * proceed.
+ *
+ * fastForward() runs through the records without simulating them (see
+ * MultiChannelMemorySystem::fastForward()) to get to a region of interest
+ * quickly with the right rows open.
+ *
+ * setExactReplay() is for replaying a recording of API calls: addresses are
+ * left as they are and a stream may issue any number of requests per cycle.
+ *
+ * saveState() records how far into each source the driver has read rather
+ * than the sources themselves; restoreState() expects sources that start
+ * from the beginning and reads them forward to the same spot, so it works
+ * for anything that produces the same records every time it runs.
+ */
+class TraceDriver : public SimulatorObject
+{
+public:
+	TraceDriver(MultiChannelMemorySystem *memorySystem, TraceSource *source, TransactionReceiver *receiver=NULL);
+	TraceDriver(MultiChannelMemorySystem *memorySystem, const vector<TraceSource *> &sources, TransactionReceiver *receiver=NULL);
+	virtual ~TraceDriver();
+
+	void update();
+	void run(uint64_t numCycles);
+	bool runToCompletion(uint64_t maxCycles=0);
+	bool issue(uint64_t numRecords);
+	void drain();
+	void rebase();
+	uint64_t fastForward(uint64_t untilCycle, uint64_t maxRecords=0);
+	bool isExhausted() const;
+	void setClosedLoop(unsigned maxOutstandingReads);
+	void setExactReplay(bool exactReplay);
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
+
+	static void alignTransactionAddress(Transaction &trans);
+
+	uint64_t recordsIssued;
+	// cycles a due read sat waiting for the outstanding read window
+	uint64_t windowStallCycles;
+
+private:
+	// records are read from a source this many at a time
+	static const unsigned STREAM_BUFFER_RECORDS = 64;
+
+	struct Stream
+	{
+		TraceSource *source;
+		deque<TraceRecord> buffer;
+		Transaction *pendingTrans;
+		uint64_t pendingCycle;
+		bool pendingQueueIfFull;
+		bool exhausted;
+		// records taken out of source so far
+		uint64_t recordsRead;
+
+		// trace clock cycles are shifted so that the first record after a
+		// rebase() lines up with the current cycle
+		bool rebasePending;
+		uint64_t traceBase;
+		uint64_t cycleBase;
+	};
+
+	void init(const vector<TraceSource *> &sources);
+	bool fetch(unsigned streamId);
+
+	MultiChannelMemorySystem *memorySystem;
+	TransactionReceiver *receiver;
+
+	vector<Stream> streams;
+	// (due cycle, stream) for every stream with a pending request
+	typedef pair<uint64_t, unsigned> StreamHead;
+	priority_queue<StreamHead, vector<StreamHead>, std::greater<StreamHead> > heads;
+	// streams that need their next record read
+	vector<unsigned> idleStreams;
+	unsigned numPending;
+
+	bool issuing;
+	unsigned maxOutstandingReads;
+	bool exactReplay;
+};
+}
+
+#endif
+
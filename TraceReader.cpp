@@ -0,0 +1,512 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TraceReader.cpp
+//
+//Class file for the trace file reader and its sidecar index
+//
+
+#include <sstream>
+#include <sys/stat.h>
+
+#include "TraceReader.h"
+#include "BusPacket.h"
+#include "Profiler.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+void *parseTraceFileLine(string &line, uint64_t &addr, enum DRAMSim::TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle)
+{
+	size_t previousIndex=0;
+	size_t spaceIndex=0;
+	uint64_t *dataBuffer = NULL;
+	string addressStr="", cmdStr="", dataStr="", ccStr="";
+
+	switch (type)
+	{
+	case k6:
+	{
+		spaceIndex = line.find_first_of(" ", 0);
+
+		addressStr = line.substr(0, spaceIndex);
+		previousIndex = spaceIndex;
+
+		spaceIndex = line.find_first_not_of(" ", previousIndex);
+		cmdStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
+		previousIndex = line.find_first_of(" ", spaceIndex);
+
+		spaceIndex = line.find_first_not_of(" ", previousIndex);
+		ccStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
+
+		if (cmdStr.compare("P_MEM_WR")==0 ||
+		        cmdStr.compare("BOFF")==0)
+		{
+			transType = DATA_WRITE;
+		}
+		else if (cmdStr.compare("P_FETCH")==0 ||
+		         cmdStr.compare("P_MEM_RD")==0 ||
+		         cmdStr.compare("P_LOCK_RD")==0 ||
+		         cmdStr.compare("P_LOCK_WR")==0)
+		{
+			transType = DATA_READ;
+		}
+		else
+		{
+			ERROR("== Unknown Command : "<<cmdStr);
+			exit(0);
+		}
+
+		istringstream a(addressStr.substr(2));//gets rid of 0x
+		a>>hex>>addr;
+
+		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
+		//  will be allowed to be issued
+		if (useClockCycle)
+		{
+			istringstream b(ccStr);
+			b>>clockCycle;
+		}
+		break;
+	}
+	case mase:
+	{
+		spaceIndex = line.find_first_of(" ", 0);
+
+		addressStr = line.substr(0, spaceIndex);
+		previousIndex = spaceIndex;
+
+		spaceIndex = line.find_first_not_of(" ", previousIndex);
+		cmdStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
+		previousIndex = line.find_first_of(" ", spaceIndex);
+
+		spaceIndex = line.find_first_not_of(" ", previousIndex);
+		ccStr = line.substr(spaceIndex, line.find_first_of(" ", spaceIndex) - spaceIndex);
+
+		if (cmdStr.compare("IFETCH")==0||
+		        cmdStr.compare("READ")==0)
+		{
+			transType = DATA_READ;
+		}
+		else if (cmdStr.compare("WRITE")==0)
+		{
+			transType = DATA_WRITE;
+		}
+		else
+		{
+			ERROR("== Unknown command in tracefile : "<<cmdStr);
+		}
+
+		istringstream a(addressStr.substr(2));//gets rid of 0x
+		a>>hex>>addr;
+
+		//if this is set to false, clockCycle will remain at 0, and every line read from the trace
+		//  will be allowed to be issued
+		if (useClockCycle)
+		{
+			istringstream b(ccStr);
+			b>>clockCycle;
+		}
+
+		break;
+	}
+	case misc:
+		spaceIndex = line.find_first_of(" ", spaceIndex+1);
+		if (spaceIndex == string::npos)
+		{
+			ERROR("Malformed line: '"<< line <<"'");
+		}
+
+		addressStr = line.substr(previousIndex,spaceIndex);
+		previousIndex=spaceIndex;
+
+		spaceIndex = line.find_first_of(" ", spaceIndex+1);
+		if (spaceIndex == string::npos)
+		{
+			cmdStr = line.substr(previousIndex+1);
+		}
+		else
+		{
+			cmdStr = line.substr(previousIndex+1,spaceIndex-previousIndex-1);
+			dataStr = line.substr(spaceIndex+1);
+		}
+
+		//convert address string -> number
+		istringstream b(addressStr.substr(2)); //substr(2) chops off 0x characters
+		b >>hex>> addr;
+
+		// parse command
+		if (cmdStr.compare("read") == 0)
+		{
+			transType=DATA_READ;
+		}
+		else if (cmdStr.compare("write") == 0)
+		{
+			transType=DATA_WRITE;
+		}
+		else
+		{
+			ERROR("INVALID COMMAND '"<<cmdStr<<"'");
+			exit(-1);
+		}
+		if (SHOW_SIM_OUTPUT)
+		{
+			DEBUGN("ADDR='"<<hex<<addr<<dec<<"',CMD='"<<transType<<"'");//',DATA='"<<dataBuffer[0]<<"'");
+		}
+
+		//parse data
+		//if we are running in a no storage mode, don't allocate space, just return NULL
+#ifndef NO_STORAGE
+		if (dataStr.size() > 0 && transType == DATA_WRITE)
+		{
+			// 32 bytes of data per transaction
+			dataBuffer = (uint64_t *)calloc(sizeof(uint64_t),4);
+			size_t strlen = dataStr.size();
+			for (int i=0; i < 4; i++)
+			{
+				size_t startIndex = i*16;
+				if (startIndex > strlen)
+				{
+					break;
+				}
+				size_t charsLeft = min(((size_t)16), strlen - startIndex + 1);
+				string piece = dataStr.substr(i*16,charsLeft);
+				istringstream iss(piece);
+				iss >> hex >> dataBuffer[i];
+			}
+			PRINTN("\tDATA=");
+			BusPacket::printData(dataBuffer);
+		}
+
+		PRINT("");
+#endif
+		break;
+	}
+	return dataBuffer;
+}
+
+TraceReader::TraceReader(const string &filename_, TraceType type, bool useClockCycle_) :
+	traceType(type),
+	useClockCycle(useClockCycle_),
+	recordNumber(0),
+	lineNumber(0),
+	forkPosition(0),
+	forkAtEnd(false),
+	filename(filename_)
+{
+	traceFile.open(filename.c_str());
+	if (!traceFile.is_open())
+	{
+		cout << "== Error - Could not open trace file"<<endl;
+		exit(0);
+	}
+}
+
+TraceReader::~TraceReader()
+{
+	traceFile.close();
+}
+
+//reads the next non-empty line of the trace into record
+bool TraceReader::next(TraceRecord &record)
+{
+	PROFILE_SCOPE(PROFILE_TRACE_PARSING);
+	while (!traceFile.eof())
+	{
+		getline(traceFile, line);
+		lineNumber++;
+		if (line.size() > 0)
+		{
+			record.clockCycle = 0;
+			record.queueIfFull = false;
+			record.data = parseTraceFileLine(line, record.address, record.transactionType, record.clockCycle, traceType, useClockCycle);
+			recordNumber++;
+			return true;
+		}
+		else if (!traceFile.eof())
+		{
+			DEBUG("WARNING: Skipping line "<<lineNumber-1<< " ('" << line << "') in tracefile");
+		}
+	}
+	return false;
+}
+
+void TraceReader::prepareFork()
+{
+	forkAtEnd = traceFile.eof();
+	forkPosition = forkAtEnd ? std::streampos(0) : traceFile.tellg();
+}
+
+void TraceReader::reopenAfterFork()
+{
+	traceFile.close();
+	traceFile.clear();
+	traceFile.open(filename.c_str());
+	if (!traceFile.is_open())
+	{
+		ERROR("Could not reopen trace file '"<<filename<<"'");
+		exit(-1);
+	}
+	if (forkAtEnd)
+	{
+		traceFile.seekg(0, ios::end);
+	}
+	else
+	{
+		traceFile.seekg(forkPosition);
+	}
+}
+
+//same as next() but doesn't bother parsing the line
+bool TraceReader::skipRecord()
+{
+	while (!traceFile.eof())
+	{
+		getline(traceFile, line);
+		lineNumber++;
+		if (line.size() > 0)
+		{
+			recordNumber++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Position the reader so that the next call to next() returns the given
+ * record. The index gets us to the closest preceding entry and the rest of
+ * the way is skipped over line by line.
+ */
+bool TraceReader::seekToRecord(uint64_t record, const TraceIndex &index)
+{
+	if (index.offsets.empty() || record >= index.numRecords)
+	{
+		return false;
+	}
+
+	uint64_t entry = min((uint64_t)(index.offsets.size()-1), record / index.interval);
+	traceFile.clear();
+	traceFile.seekg(index.offsets[entry]);
+	recordNumber = entry * index.interval;
+	// line numbers are only used for warnings, so don't worry about keeping them exact
+	lineNumber = recordNumber;
+
+	while (recordNumber < record)
+	{
+		if (!skipRecord())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void TraceReader::rewind()
+{
+	traceFile.clear();
+	traceFile.seekg(0);
+	recordNumber = 0;
+	lineNumber = 0;
+}
+
+uint64_t TraceReader::getRecordNumber() const
+{
+	return recordNumber;
+}
+
+uint64_t TraceReader::tell()
+{
+	return (uint64_t)traceFile.tellg();
+}
+
+//the prefix of the trace name determines its format (ex: k6_foo.trc)
+bool TraceReader::typeFromFilename(const string &filename, TraceType &type)
+{
+	string temp = filename.substr(filename.find_last_of("/")+1);
+	temp = temp.substr(0,temp.find_first_of("_"));
+	if (temp=="mase")
+	{
+		type = mase;
+	}
+	else if (temp=="k6")
+	{
+		type = k6;
+	}
+	else if (temp=="misc")
+	{
+		type = misc;
+	}
+	else
+	{
+		ERROR("== Unknown Tracefile Type : "<<temp);
+		return false;
+	}
+	return true;
+}
+
+TraceBuffer::TraceBuffer(const vector<TraceRecord> &records_) :
+	records(records_),
+	position(0)
+{}
+
+bool TraceBuffer::next(TraceRecord &record)
+{
+	if (position >= records.size())
+	{
+		return false;
+	}
+	record = records[position++];
+	return true;
+}
+
+// read everything a source has to offer into records
+void TraceBuffer::load(TraceSource &source, vector<TraceRecord> &records)
+{
+	TraceRecord record;
+	while (source.next(record))
+	{
+		records.push_back(record);
+	}
+}
+
+TraceIndex::TraceIndex() :
+	interval(0),
+	numRecords(0),
+	traceSize(0)
+{}
+
+// walk the whole trace once and remember where every interval-th record starts
+void TraceIndex::build(TraceReader &reader, uint64_t interval_)
+{
+	interval = interval_;
+	offsets.clear();
+	reader.rewind();
+
+	uint64_t offset = reader.tell();
+	while (reader.skipRecord())
+	{
+		if ((reader.getRecordNumber()-1) % interval == 0)
+		{
+			offsets.push_back(offset);
+		}
+		offset = reader.tell();
+	}
+	numRecords = reader.getRecordNumber();
+	traceSize = fileSize(reader.filename);
+	reader.rewind();
+}
+
+bool TraceIndex::load(const string &filename, const string &traceFilename)
+{
+	ifstream in(filename.c_str(), ios::binary);
+	if (!in.is_open())
+	{
+		return false;
+	}
+
+	uint32_t magic, version;
+	uint64_t numEntries;
+	in.read((char *)&magic, sizeof(magic));
+	in.read((char *)&version, sizeof(version));
+	if (!in || magic != MAGIC || version != VERSION)
+	{
+		ERROR("'"<<filename<<"' is not a trace index (or is from a different version)");
+		return false;
+	}
+	in.read((char *)&interval, sizeof(interval));
+	in.read((char *)&numRecords, sizeof(numRecords));
+	in.read((char *)&traceSize, sizeof(traceSize));
+	in.read((char *)&numEntries, sizeof(numEntries));
+	// the offsets fill the rest of the file; a count that doesn't match is
+	// a truncated or garbled index, not something to allocate for
+	uint64_t headerSize = 2*sizeof(uint32_t) + 4*sizeof(uint64_t);
+	uint64_t indexSize = fileSize(filename);
+	if (!in || indexSize < headerSize || numEntries != (indexSize - headerSize) / sizeof(uint64_t))
+	{
+		ERROR("Trace index '"<<filename<<"' is truncated, rebuild it with --build-index");
+		return false;
+	}
+	offsets.resize(numEntries);
+	if (numEntries > 0)
+	{
+		in.read((char *)&offsets[0], numEntries*sizeof(uint64_t));
+	}
+	if (!in || interval == 0)
+	{
+		ERROR("Trace index '"<<filename<<"' is truncated");
+		return false;
+	}
+	if (traceSize != fileSize(traceFilename))
+	{
+		ERROR("Trace index '"<<filename<<"' is stale (trace file changed size), rebuild it with --build-index");
+		return false;
+	}
+	return true;
+}
+
+void TraceIndex::save(const string &filename) const
+{
+	ofstream out(filename.c_str(), ios::binary | ios::trunc);
+	if (!out.is_open())
+	{
+		ERROR("Cannot open '"<<filename<<"' for writing");
+		exit(-1);
+	}
+	uint32_t magic = MAGIC, version = VERSION;
+	uint64_t numEntries = offsets.size();
+	out.write((const char *)&magic, sizeof(magic));
+	out.write((const char *)&version, sizeof(version));
+	out.write((const char *)&interval, sizeof(interval));
+	out.write((const char *)&numRecords, sizeof(numRecords));
+	out.write((const char *)&traceSize, sizeof(traceSize));
+	out.write((const char *)&numEntries, sizeof(numEntries));
+	if (numEntries > 0)
+	{
+		out.write((const char *)&offsets[0], numEntries*sizeof(uint64_t));
+	}
+}
+
+string TraceIndex::sidecarFilename(const string &traceFilename)
+{
+	return traceFilename + ".idx";
+}
+
+uint64_t TraceIndex::fileSize(const string &filename)
+{
+	struct stat stat_buf;
+	if (stat(filename.c_str(), &stat_buf) != 0)
+	{
+		return 0;
+	}
+	return (uint64_t)stat_buf.st_size;
+}
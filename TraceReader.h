@@ -0,0 +1,160 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+
+//TraceReader.h
+//
+//Header file for the trace file reader and its sidecar index
+//
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SystemConfiguration.h"
+#include "Transaction.h"
+
+using std::string;
+using std::vector;
+
+void *parseTraceFileLine(string &line, uint64_t &addr, enum DRAMSim::TransactionType &transType, uint64_t &clockCycle, TraceType type, bool useClockCycle);
+
+namespace DRAMSim
+{
+
+// a single request as it comes out of a trace (or anything that acts like one)
+struct TraceRecord
+{
+	uint64_t address;
+	TransactionType transactionType;
+	uint64_t clockCycle;
+	void *data;
+	// issue through addTransaction(isWrite, addr), which queues the request
+	// in the MemorySystem instead of refusing it when the controller is full
+	bool queueIfFull;
+};
+
+/*
+ * TraceSource: anything that can feed records to the TraceDriver. The
+ * records should come out in non-decreasing clockCycle order.
+ */
+class TraceSource
+{
+public:
+	virtual ~TraceSource() {}
+	virtual bool next(TraceRecord &record)=0;
+
+	// a process forked off with a source open shares the file offset with
+	// its parent; prepareFork() is called just before fork() and
+	// reopenAfterFork() in the child so it gets a file of its own
+	virtual void prepareFork() {}
+	virtual void reopenAfterFork() {}
+};
+
+class TraceIndex;
+
+class TraceReader : public TraceSource
+{
+	std::ifstream traceFile;
+	string line;
+	TraceType traceType;
+	bool useClockCycle;
+	uint64_t recordNumber;
+	uint64_t lineNumber;
+	std::streampos forkPosition;
+	bool forkAtEnd;
+
+public:
+	TraceReader(const string &filename, TraceType type, bool useClockCycle);
+	virtual ~TraceReader();
+	bool next(TraceRecord &record);
+	void prepareFork();
+	void reopenAfterFork();
+	bool skipRecord();
+	bool seekToRecord(uint64_t record, const TraceIndex &index);
+	void rewind();
+	uint64_t getRecordNumber() const;
+	uint64_t tell();
+
+	static bool typeFromFilename(const string &filename, TraceType &type);
+
+	const string filename;
+};
+
+/*
+ * TraceBuffer: replays records that were read into memory beforehand, so a
+ * trace is parsed once no matter how many runs use it. The records belong to
+ * the caller and must outlive the buffer.
+ */
+class TraceBuffer : public TraceSource
+{
+	const vector<TraceRecord> &records;
+	size_t position;
+
+public:
+	TraceBuffer(const vector<TraceRecord> &records);
+	bool next(TraceRecord &record);
+
+	static void load(TraceSource &source, vector<TraceRecord> &records);
+};
+
+/*
+ * TraceIndex: sidecar file (tracefile.idx) that stores the byte offset of
+ * every Nth record of a trace so that a sampled simulation can seek
+ * directly to a window instead of reading everything before it.
+ *
+ * The file is a small binary header followed by one uint64_t offset per
+ * entry; the trace size is recorded so a stale index can be detected.
+ */
+class TraceIndex
+{
+public:
+	static const uint32_t MAGIC = 0x58495344; // "DSIX"
+	static const uint32_t VERSION = 1;
+
+	uint64_t interval;
+	uint64_t numRecords;
+	uint64_t traceSize;
+	vector<uint64_t> offsets;
+
+	TraceIndex();
+	void build(TraceReader &reader, uint64_t interval);
+	bool load(const string &filename, const string &traceFilename);
+	void save(const string &filename) const;
+
+	static string sidecarFilename(const string &traceFilename);
+	static uint64_t fileSize(const string &filename);
+};
+
+}
+
+#endif
+
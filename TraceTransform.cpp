@@ -0,0 +1,92 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TraceTransform.cpp
+//
+//Class file for the on-the-fly trace rescaling/relocation wrapper
+//
+
+#include "TraceTransform.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+TraceTransform::TraceTransform(TraceSource *source_, double rateScale_, uint64_t addressOffset_, uint64_t memorySize_, bool ownsSource_) :
+	source(source_),
+	rateScale(rateScale_),
+	addressOffset(addressOffset_),
+	memorySize(memorySize_),
+	ownsSource(ownsSource_)
+{
+	if (rateScale <= 0.0)
+	{
+		ERROR("Rate scale must be positive, got "<<rateScale);
+		exit(-1);
+	}
+}
+
+TraceTransform::~TraceTransform()
+{
+	if (ownsSource)
+	{
+		delete source;
+	}
+}
+
+bool TraceTransform::next(TraceRecord &record)
+{
+	if (!source->next(record))
+	{
+		return false;
+	}
+
+	// scaling the absolute cycle scales every gap between requests by the same amount
+	if (rateScale != 1.0)
+	{
+		record.clockCycle = (uint64_t)((double)record.clockCycle / rateScale);
+	}
+	if (addressOffset != 0)
+	{
+		record.address = (record.address + addressOffset) % memorySize;
+	}
+	return true;
+}
+
+void TraceTransform::prepareFork()
+{
+	source->prepareFork();
+}
+
+void TraceTransform::reopenAfterFork()
+{
+	source->reopenAfterFork();
+}
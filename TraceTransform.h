@@ -0,0 +1,72 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRACETRANSFORM_H
+#define TRACETRANSFORM_H
+
+//TraceTransform.h
+//
+//Header file for the on-the-fly trace rescaling/relocation wrapper
+//
+
+#include "TraceReader.h"
+
+namespace DRAMSim
+{
+/*
+ * TraceTransform: wraps another TraceSource and rewrites each record as it
+ * goes by, so a scaled or relocated copy of a trace never has to be written
+ * out.
+ *
+ *   rateScale     : clock cycles are divided by this, so 2.0 replays the
+ *                   trace at twice its request rate and 0.5 at half
+ *   addressOffset : added to every address, wrapping around memorySize
+ *                   (lets copies of one trace act like independent cores)
+ */
+class TraceTransform : public TraceSource
+{
+public:
+	TraceTransform(TraceSource *source, double rateScale, uint64_t addressOffset, uint64_t memorySize, bool ownsSource=true);
+	virtual ~TraceTransform();
+	bool next(TraceRecord &record);
+	void prepareFork();
+	void reopenAfterFork();
+
+private:
+	TraceSource *source;
+	double rateScale;
+	uint64_t addressOffset;
+	uint64_t memorySize;
+	bool ownsSource;
+};
+}
+
+#endif
+
@@ -0,0 +1,316 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TrafficGenerator.cpp
+//
+//Class file for the synthetic request generator
+//
+
+#include <cstdlib>
+
+#include "TrafficGenerator.h"
+#include "AddressMapping.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+TrafficGenerator::TrafficGenerator(const IniReader::OverrideMap &options, bool useClockCycle_) :
+	pattern(Random),
+	rate(1.0),
+	footprint(((uint64_t)TOTAL_STORAGE * NUM_CHANS) << 20),
+	stride(4096),
+	hitRate(0.5),
+	readFraction(1.0),
+	count(0),
+	seed(1),
+	useClockCycle(useClockCycle_),
+	transactionSize((JEDEC_DATA_BUS_BITS/8)*BL),
+	generated(0),
+	clockCycle(0.0),
+	lastAddress(0)
+{
+	for (IniReader::OverrideIterator it = options.begin(); it != options.end(); it++)
+	{
+		const string &key = it->first;
+		const string &value = it->second;
+		if (key == "pattern")
+		{
+			if (value == "seq")
+			{
+				pattern = Sequential;
+			}
+			else if (value == "random")
+			{
+				pattern = Random;
+			}
+			else if (value == "strided")
+			{
+				pattern = Strided;
+			}
+			else if (value == "bankconflict")
+			{
+				pattern = BankConflict;
+			}
+			else if (value == "rowhit")
+			{
+				pattern = RowHit;
+			}
+			else
+			{
+				ERROR("Unknown traffic pattern '"<<value<<"' (expected seq, random, strided, bankconflict or rowhit)");
+				exit(-1);
+			}
+		}
+		else if (key == "rate")
+		{
+			rate = atof(value.c_str());
+		}
+		else if (key == "footprint")
+		{
+			footprint = parseSize(value);
+		}
+		else if (key == "stride")
+		{
+			stride = parseSize(value);
+		}
+		else if (key == "hitrate")
+		{
+			hitRate = atof(value.c_str());
+		}
+		else if (key == "reads")
+		{
+			readFraction = atof(value.c_str());
+		}
+		else if (key == "count")
+		{
+			count = strtoull(value.c_str(), NULL, 10);
+		}
+		else if (key == "seed")
+		{
+			seed = strtoull(value.c_str(), NULL, 10);
+		}
+		else
+		{
+			ERROR("Unknown traffic generator option '"<<key<<"'");
+			exit(-1);
+		}
+	}
+
+	if (rate <= 0.0 || rate > 1.0)
+	{
+		ERROR("Traffic generator rate must be in (0,1] requests per cycle, got "<<rate);
+		exit(-1);
+	}
+	if (footprint < transactionSize || footprint > (((uint64_t)TOTAL_STORAGE * NUM_CHANS) << 20))
+	{
+		ERROR("Traffic generator footprint must be between "<<transactionSize<<" and "<<(((uint64_t)TOTAL_STORAGE * NUM_CHANS) << 20)<<" bytes, got "<<footprint);
+		exit(-1);
+	}
+	if (stride == 0 || stride % transactionSize != 0)
+	{
+		ERROR("Traffic generator stride must be a non-zero multiple of the "<<transactionSize<<" byte request size");
+		exit(-1);
+	}
+
+	// xorshift gets stuck on an all zero state
+	rngState = seed ^ 0x9E3779B97F4A7C15ULL;
+	if (rngState == 0)
+	{
+		rngState = 1;
+	}
+
+	buildInverseMapping();
+}
+
+string TrafficGenerator::getName(const IniReader::OverrideMap &options)
+{
+	IniReader::OverrideIterator it = options.find("pattern");
+	return "synthetic_" + ((it != options.end()) ? it->second : string("random"));
+}
+
+/*
+ * Every mapping scheme just slices the address into bit fields, so feeding
+ * addressMapping() one bit at a time says which bit of which field each
+ * address bit ends up in.
+ */
+void TrafficGenerator::buildInverseMapping()
+{
+	unsigned offsetBits = dramsim_log2(transactionSize);
+	// TOTAL_STORAGE is in MB per channel
+	unsigned totalBits = dramsim_log2(TOTAL_STORAGE * NUM_CHANS) + 20;
+	for (unsigned i=0; i<NUM_FIELDS; i++)
+	{
+		fieldBits[i].clear();
+	}
+
+	for (unsigned bit=offsetBits; bit<totalBits; bit++)
+	{
+		unsigned value[NUM_FIELDS];
+		addressMapping(1ULL << bit, value[ChannelField], value[RankField], value[BankField], value[RowField], value[ColumnField]);
+		for (unsigned f=0; f<NUM_FIELDS; f++)
+		{
+			if (value[f] != 0)
+			{
+				unsigned position = dramsim_log2(value[f]);
+				if (fieldBits[f].size() <= position)
+				{
+					fieldBits[f].resize(position+1, 0);
+				}
+				fieldBits[f][position] = bit;
+				break;
+			}
+		}
+	}
+}
+
+uint64_t TrafficGenerator::getField(uint64_t address, Field field) const
+{
+	uint64_t value = 0;
+	for (size_t i=0; i<fieldBits[field].size(); i++)
+	{
+		value |= ((address >> fieldBits[field][i]) & 1ULL) << i;
+	}
+	return value;
+}
+
+uint64_t TrafficGenerator::setField(uint64_t address, Field field, uint64_t value) const
+{
+	for (size_t i=0; i<fieldBits[field].size(); i++)
+	{
+		uint64_t bit = 1ULL << fieldBits[field][i];
+		if ((value >> i) & 1ULL)
+		{
+			address |= bit;
+		}
+		else
+		{
+			address &= ~bit;
+		}
+	}
+	return address;
+}
+
+uint64_t TrafficGenerator::nextAddress()
+{
+	uint64_t numRequests = footprint / transactionSize;
+	uint64_t randomAddress = (random() % numRequests) * transactionSize;
+
+	switch (pattern)
+	{
+	case Sequential:
+		return (generated % numRequests) * transactionSize;
+	case Strided:
+		return (generated * stride) % (numRequests * transactionSize);
+	case Random:
+		return randomAddress;
+	case BankConflict:
+	{
+		// everything goes to the bank of the first request, always to a different row
+		if (generated == 0)
+		{
+			return randomAddress;
+		}
+		uint64_t address = randomAddress;
+		address = setField(address, ChannelField, getField(lastAddress, ChannelField));
+		address = setField(address, RankField, getField(lastAddress, RankField));
+		address = setField(address, BankField, getField(lastAddress, BankField));
+		if (getField(address, RowField) == getField(lastAddress, RowField))
+		{
+			address = setField(address, RowField, getField(lastAddress, RowField) ^ 1);
+		}
+		return address;
+	}
+	case RowHit:
+		// a hit is the last row with some other column
+		if (generated > 0 && uniform() < hitRate)
+		{
+			return setField(lastAddress, ColumnField, getField(randomAddress, ColumnField));
+		}
+		return randomAddress;
+	}
+	return randomAddress;
+}
+
+bool TrafficGenerator::next(TraceRecord &record)
+{
+	if (count > 0 && generated >= count)
+	{
+		return false;
+	}
+
+	record.address = nextAddress();
+	record.transactionType = (uniform() < readFraction) ? DATA_READ : DATA_WRITE;
+	record.clockCycle = useClockCycle ? (uint64_t)clockCycle : 0;
+	record.data = NULL;
+	record.queueIfFull = false;
+
+	lastAddress = record.address;
+	clockCycle += 1.0 / rate;
+	generated++;
+	return true;
+}
+
+// xorshift64*
+uint64_t TrafficGenerator::random()
+{
+	rngState ^= rngState >> 12;
+	rngState ^= rngState << 25;
+	rngState ^= rngState >> 27;
+	return rngState * 2685821657736338717ULL;
+}
+
+double TrafficGenerator::uniform()
+{
+	return (random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint64_t TrafficGenerator::parseSize(const string &value)
+{
+	char *end;
+	uint64_t size = strtoull(value.c_str(), &end, 10);
+	switch (*end)
+	{
+	case 'k':
+	case 'K':
+		size <<= 10;
+		break;
+	case 'm':
+	case 'M':
+		size <<= 20;
+		break;
+	case 'g':
+	case 'G':
+		size <<= 30;
+		break;
+	}
+	return size;
+}
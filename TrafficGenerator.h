@@ -0,0 +1,127 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRAFFICGENERATOR_H
+#define TRAFFICGENERATOR_H
+
+//TrafficGenerator.h
+//
+//Header file for the synthetic request generator
+//
+
+#include <string>
+#include <vector>
+#include "TraceReader.h"
+#include "IniReader.h"
+
+using std::string;
+using std::vector;
+
+namespace DRAMSim
+{
+/*
+ * TrafficGenerator: a TraceSource that makes up requests instead of reading
+ * them from a file. It is configured with the same key=value,key=value
+ * syntax as -o:
+ *
+ *   pattern   : seq | random | strided | bankconflict | rowhit
+ *   rate      : requests per CPU cycle (0 < rate <= 1)        [1.0]
+ *   footprint : bytes touched, K/M/G suffixes allowed          [whole memory]
+ *   stride    : bytes between requests for 'strided'           [4K]
+ *   hitrate   : fraction of row hits for 'rowhit'              [0.5]
+ *   reads     : fraction of requests that are reads            [1.0]
+ *   count     : number of requests, 0 for no limit             [0]
+ *   seed      : random seed                                    [1]
+ *
+ * Addresses are built through the inverse of the configured address mapping
+ * so that 'bankconflict' and 'rowhit' hit the rows/banks they claim to for
+ * any ADDRESS_MAPPING_SCHEME.
+ */
+class TrafficGenerator : public TraceSource
+{
+public:
+	enum Pattern
+	{
+		Sequential,
+		Random,
+		Strided,
+		BankConflict,
+		RowHit
+	};
+
+	TrafficGenerator(const IniReader::OverrideMap &options, bool useClockCycle);
+	bool next(TraceRecord &record);
+
+	static string getName(const IniReader::OverrideMap &options);
+
+private:
+	enum Field
+	{
+		ChannelField,
+		RankField,
+		BankField,
+		RowField,
+		ColumnField,
+		NUM_FIELDS
+	};
+
+	void buildInverseMapping();
+	uint64_t setField(uint64_t address, Field field, uint64_t value) const;
+	uint64_t getField(uint64_t address, Field field) const;
+	uint64_t nextAddress();
+
+	uint64_t random();
+	double uniform();
+
+	static uint64_t parseSize(const string &value);
+
+	Pattern pattern;
+	double rate;
+	uint64_t footprint;
+	uint64_t stride;
+	double hitRate;
+	double readFraction;
+	uint64_t count;
+	uint64_t seed;
+	bool useClockCycle;
+
+	uint64_t transactionSize;
+	// address bit positions that make up each field, least significant first
+	vector<unsigned> fieldBits[NUM_FIELDS];
+
+	uint64_t rngState;
+	uint64_t generated;
+	double clockCycle;
+	uint64_t lastAddress;
+};
+}
+
+#endif
+
@@ -46,15 +46,31 @@ namespace DRAMSim {
 Transaction::Transaction(TransactionType transType, uint64_t addr, void *dat) :
 	transactionType(transType),
 	address(addr),
-	data(dat)
+	data(dat),
+	timeCreated(0),
+	timeAdded(0),
+	timeScheduled(0),
+	timeActivated(0),
+	timeIssued(0),
+	refreshBeforeActivate(0),
+	refreshBeforeIssue(0),
+	timeReturned(0),
+	sourceId(0)
 {}
 
 Transaction::Transaction(const Transaction &t)
 	: transactionType(t.transactionType)
 	  , address(t.address)
 	  , data(NULL)
+	  , timeCreated(t.timeCreated)
 	  , timeAdded(t.timeAdded)
+	  , timeScheduled(t.timeScheduled)
+	  , timeActivated(t.timeActivated)
+	  , timeIssued(t.timeIssued)
+	  , refreshBeforeActivate(t.refreshBeforeActivate)
+	  , refreshBeforeIssue(t.refreshBeforeIssue)
 	  , timeReturned(t.timeReturned)
+	  , sourceId(t.sourceId)
 {
 	#ifndef NO_STORAGE
 	ERROR("Data storage is really outdated and these copies happen in an \n improper way, which will eventually cause problems. Please send an \n email to dramninjas [at] gmail [dot] com if you need data storage");
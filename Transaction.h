@@ -57,8 +57,21 @@ public:
 	TransactionType transactionType;
 	uint64_t address;
 	void *data;
+	// when the request reached each stage (DRAM cycles) for the read latency
+	// breakdown: the memory system (pendingTransactions), the transaction
+	// queue, the command queue, its ACT and its CAS going out; a read
+	// returning with its data carries the last two over from the bus packet
+	uint64_t timeCreated;
 	uint64_t timeAdded;
+	uint64_t timeScheduled;
+	uint64_t timeActivated;
+	uint64_t timeIssued;
+	// cycles its rank was held for a refresh while it waited for the ACT / CAS
+	uint64_t refreshBeforeActivate;
+	uint64_t refreshBeforeIssue;
 	uint64_t timeReturned;
+	// which front end stream (core, trace) the request came from
+	unsigned sourceId;
 
 
 	friend ostream &operator<<(ostream &os, const Transaction &t);
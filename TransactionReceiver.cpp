@@ -0,0 +1,326 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+
+//TransactionReceiver.cpp
+//
+//Class file for the trace front end's completion tracker
+//
+
+#include "TransactionReceiver.h"
+#include "Checkpoint.h"
+
+using namespace DRAMSim;
+using namespace std;
+
+TransactionReceiver::TransactionReceiver() :
+	outstandingRequests(0),
+	outstandingReads(0),
+	measuring(true),
+	bucketLength(0)
+{
+	resetStats();
+}
+
+void TransactionReceiver::add_pending(TransactionType type, uint64_t address, uint64_t cycle, unsigned sourceId)
+{
+	PendingRequest request;
+	request.addedCycle = cycle;
+	request.sourceId = sourceId;
+	request.measured = measuring;
+
+	// C++ lists are ordered, so the list will always push to the back and
+	// remove at the front to ensure ordering
+	if (type == DATA_READ)
+	{
+		countShared(pendingReadRequests[address], request);
+		pendingReadRequests[address].push_back(request);
+		outstandingReads++;
+		getSource(sourceId).outstandingReads++;
+	}
+	else if (type == DATA_WRITE)
+	{
+		countShared(pendingWriteRequests[address], request);
+		pendingWriteRequests[address].push_back(request);
+	}
+	else
+	{
+		ERROR("This should never happen");
+		exit(-1);
+	}
+	outstandingRequests++;
+
+	if (measuring && cycle < firstIssueCycle)
+	{
+		firstIssueCycle = cycle;
+	}
+}
+
+// completions only carry an address, so a request queued behind another
+// source's request to the same address may be credited to the wrong source
+void TransactionReceiver::countShared(const list<PendingRequest> &requests, const PendingRequest &request)
+{
+	if (!request.measured)
+	{
+		return;
+	}
+	for (list<PendingRequest>::const_iterator it=requests.begin(); it!=requests.end(); it++)
+	{
+		if (it->sourceId != request.sourceId)
+		{
+			sharedAddressRequests++;
+			return;
+		}
+	}
+}
+
+TransactionReceiver::PendingRequest TransactionReceiver::complete(map<uint64_t, list<PendingRequest> > &pending, uint64_t address)
+{
+	map<uint64_t, list<PendingRequest> >::iterator it;
+	it = pending.find(address);
+	if (it == pending.end() || it->second.size() == 0)
+	{
+		ERROR("Cant find a pending request for 0x"<<hex<<address<<dec);
+		exit(-1);
+	}
+
+	PendingRequest request = it->second.front();
+	it->second.pop_front();
+	// don't let the map grow with every address that was ever touched
+	if (it->second.empty())
+	{
+		pending.erase(it);
+	}
+	outstandingRequests--;
+	return request;
+}
+
+void TransactionReceiver::read_complete(unsigned id, uint64_t address, uint64_t done_cycle)
+{
+	PendingRequest request = complete(pendingReadRequests, address);
+	SourceStats &source = getSource(request.sourceId);
+	outstandingReads--;
+	source.outstandingReads--;
+	uint64_t latency = done_cycle - request.addedCycle;
+	if (request.measured)
+	{
+		reads++;
+		totalReadLatency += latency;
+		lastDoneCycle = max(lastDoneCycle, done_cycle);
+		source.reads++;
+		source.totalReadLatency += latency;
+		if (bucketLength > 0)
+		{
+			readLatencyHistogram[latency / HISTOGRAM_BIN_SIZE]++;
+		}
+	}
+	if (bucketLength > 0)
+	{
+		BucketStats &bucket = getBucket(request.addedCycle);
+		bucket.reads++;
+		bucket.totalReadLatency += latency;
+	}
+#ifdef RETURN_TRANSACTIONS
+	cout << "Read Callback:  0x"<< std::hex << address << std::dec << " latency="<<latency<<"cycles ("<< done_cycle<< "->"<<request.addedCycle<<")"<<endl;
+#endif
+}
+
+void TransactionReceiver::write_complete(unsigned id, uint64_t address, uint64_t done_cycle)
+{
+	PendingRequest request = complete(pendingWriteRequests, address);
+	if (request.measured)
+	{
+		writes++;
+		lastDoneCycle = max(lastDoneCycle, done_cycle);
+		getSource(request.sourceId).writes++;
+	}
+	if (bucketLength > 0)
+	{
+		getBucket(request.addedCycle).writes++;
+	}
+#ifdef RETURN_TRANSACTIONS
+	uint64_t latency = done_cycle - request.addedCycle;
+	cout << "Write Callback: 0x"<< std::hex << address << std::dec << " latency="<<latency<<"cycles ("<< done_cycle<< "->"<<request.addedCycle<<")"<<endl;
+#endif
+}
+
+//requests issued from now on will (or won't) be counted in the stats
+void TransactionReceiver::setMeasuring(bool measuring_)
+{
+	measuring = measuring_;
+}
+
+void TransactionReceiver::setBucketLength(uint64_t bucketLength_)
+{
+	bucketLength = bucketLength_;
+	buckets.clear();
+	readLatencyHistogram.clear();
+}
+
+TransactionReceiver::BucketStats &TransactionReceiver::getBucket(uint64_t issueCycle)
+{
+	size_t index = issueCycle / bucketLength;
+	if (index >= buckets.size())
+	{
+		BucketStats empty = {0, 0, 0};
+		buckets.resize(index+1, empty);
+	}
+	return buckets[index];
+}
+
+void TransactionReceiver::resetStats()
+{
+	reads = 0;
+	writes = 0;
+	totalReadLatency = 0;
+	sharedAddressRequests = 0;
+	firstIssueCycle = (uint64_t)-1;
+	lastDoneCycle = 0;
+	for (size_t i=0; i<sourceStats.size(); i++)
+	{
+		sourceStats[i].reads = 0;
+		sourceStats[i].writes = 0;
+		sourceStats[i].totalReadLatency = 0;
+	}
+}
+
+TransactionReceiver::SourceStats &TransactionReceiver::getSource(unsigned sourceId)
+{
+	if (sourceId >= sourceStats.size())
+	{
+		SourceStats empty = {0, 0, 0, 0};
+		sourceStats.resize(sourceId+1, empty);
+	}
+	return sourceStats[sourceId];
+}
+
+uint64_t TransactionReceiver::getOutstanding() const
+{
+	return outstandingRequests;
+}
+
+uint64_t TransactionReceiver::getOutstandingReads() const
+{
+	return outstandingReads;
+}
+
+uint64_t TransactionReceiver::getOutstandingReads(unsigned sourceId) const
+{
+	return (sourceId < sourceStats.size()) ? sourceStats[sourceId].outstandingReads : 0;
+}
+
+void TransactionReceiver::printSourceStats(ostream &out) const
+{
+	out << "== Per source stats =="<<endl;
+	for (size_t i=0; i<sourceStats.size(); i++)
+	{
+		const SourceStats &source = sourceStats[i];
+		out << "   Source "<<i<<" : "<<source.reads<<" reads, "<<source.writes<<" writes, average read latency "
+			<< ((source.reads > 0) ? (double)source.totalReadLatency / source.reads * tCK : 0.0)<<" ns"<<endl;
+	}
+	if (sharedAddressRequests > 0)
+	{
+		out << "   WARNING: "<<sharedAddressRequests<<" requests went to an address another source already had a request outstanding to;"
+			<<" completions are matched to the oldest of these, so those requests (and the closed loop windows) may be counted against the wrong source"<<endl;
+	}
+}
+
+void TransactionReceiver::savePending(CheckpointWriter &checkpoint, const map<uint64_t, list<PendingRequest> > &pending)
+{
+	checkpoint.write<uint64_t>(pending.size());
+	for (map<uint64_t, list<PendingRequest> >::const_iterator it=pending.begin(); it!=pending.end(); it++)
+	{
+		checkpoint.write(it->first);
+		checkpoint.write<uint64_t>(it->second.size());
+		for (list<PendingRequest>::const_iterator req=it->second.begin(); req!=it->second.end(); req++)
+		{
+			checkpoint.write(req->addedCycle);
+			checkpoint.write(req->sourceId);
+			checkpoint.write(req->measured);
+		}
+	}
+}
+
+void TransactionReceiver::restorePending(CheckpointReader &checkpoint, map<uint64_t, list<PendingRequest> > &pending)
+{
+	uint64_t numAddresses;
+	pending.clear();
+	checkpoint.read(numAddresses);
+	for (uint64_t i=0; i<numAddresses; i++)
+	{
+		uint64_t address, numRequests;
+		checkpoint.read(address);
+		checkpoint.read(numRequests);
+		list<PendingRequest> &requests = pending[address];
+		for (uint64_t j=0; j<numRequests; j++)
+		{
+			PendingRequest request;
+			checkpoint.read(request.addedCycle);
+			checkpoint.read(request.sourceId);
+			checkpoint.read(request.measured);
+			requests.push_back(request);
+		}
+	}
+}
+
+void TransactionReceiver::saveState(CheckpointWriter &checkpoint) const
+{
+	checkpoint.writeSection(CHECKPOINT_RECEIVER);
+	savePending(checkpoint, pendingReadRequests);
+	savePending(checkpoint, pendingWriteRequests);
+	checkpoint.write(outstandingRequests);
+	checkpoint.write(outstandingReads);
+	checkpoint.write(measuring);
+	checkpoint.write(reads);
+	checkpoint.write(writes);
+	checkpoint.write(totalReadLatency);
+	checkpoint.write(sharedAddressRequests);
+	checkpoint.write(firstIssueCycle);
+	checkpoint.write(lastDoneCycle);
+	checkpoint.writeVector(sourceStats);
+}
+
+void TransactionReceiver::restoreState(CheckpointReader &checkpoint)
+{
+	checkpoint.readSection(CHECKPOINT_RECEIVER);
+	restorePending(checkpoint, pendingReadRequests);
+	restorePending(checkpoint, pendingWriteRequests);
+	checkpoint.read(outstandingRequests);
+	checkpoint.read(outstandingReads);
+	checkpoint.read(measuring);
+	checkpoint.read(reads);
+	checkpoint.read(writes);
+	checkpoint.read(totalReadLatency);
+	checkpoint.read(sharedAddressRequests);
+	checkpoint.read(firstIssueCycle);
+	checkpoint.read(lastDoneCycle);
+	checkpoint.readVector(sourceStats);
+}
@@ -0,0 +1,153 @@
+/*********************************************************************************
+*  Copyright (c) 2010-2011, Elliott Cooper-Balis
+*                             Paul Rosenfeld
+*                             Bruce Jacob
+*                             University of Maryland 
+*                             dramninjas [at] gmail [dot] com
+*  All rights reserved.
+*  
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions are met:
+*  
+*     * Redistributions of source code must retain the above copyright notice,
+*        this list of conditions and the following disclaimer.
+*  
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*        this list of conditions and the following disclaimer in the documentation
+*        and/or other materials provided with the distribution.
+*  
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef TRANSACTIONRECEIVER_H
+#define TRANSACTIONRECEIVER_H
+
+//TransactionReceiver.h
+//
+//Header file for the trace front end's completion tracker
+//
+
+#include <map>
+#include <list>
+#include <vector>
+#include <ostream>
+#include "Transaction.h"
+
+using std::map;
+using std::list;
+using std::vector;
+using std::ostream;
+
+// print every completion as it comes back
+//#define RETURN_TRANSACTIONS 1
+
+namespace DRAMSim
+{
+class CheckpointWriter;
+class CheckpointReader;
+
+/*
+ * TransactionReceiver: gets the read/write completion callbacks from the
+ * memory system and matches them up with the cycle each request was added so
+ * the front end knows what is still in flight and how long things took.
+ *
+ * Only requests issued while measuring() is on are counted in the stats;
+ * this lets warm-up requests flow through without polluting a sample.
+ *
+ * setBucketLength() additionally splits every completed request, measured
+ * or not, into buckets by the cycle it was issued on, and keeps a histogram
+ * of the measured read latencies; a time-parallel run stitches segments
+ * back together from these.
+ *
+ * Completions only carry an address, so when several sources touch the same
+ * address the oldest outstanding request to it is assumed to be the one that
+ * finished, which is the order the memory controller returns them in (the
+ * controller matches its own returns by address the same way). Requests that
+ * are ambiguous this way are counted in sharedAddressRequests and reported
+ * with the per source stats.
+ */
+class TransactionReceiver
+{
+public:
+	struct SourceStats
+	{
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t totalReadLatency;
+		uint64_t outstandingReads;
+	};
+
+	struct BucketStats
+	{
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t totalReadLatency;
+	};
+
+private:
+	struct PendingRequest
+	{
+		uint64_t addedCycle;
+		unsigned sourceId;
+		bool measured;
+	};
+	map<uint64_t, list<PendingRequest> > pendingReadRequests;
+	map<uint64_t, list<PendingRequest> > pendingWriteRequests;
+	uint64_t outstandingRequests;
+	uint64_t outstandingReads;
+	bool measuring;
+
+	void countShared(const list<PendingRequest> &requests, const PendingRequest &request);
+	PendingRequest complete(map<uint64_t, list<PendingRequest> > &pending, uint64_t address);
+	static void savePending(CheckpointWriter &checkpoint, const map<uint64_t, list<PendingRequest> > &pending);
+	static void restorePending(CheckpointReader &checkpoint, map<uint64_t, list<PendingRequest> > &pending);
+	SourceStats &getSource(unsigned sourceId);
+
+public:
+	TransactionReceiver();
+	void add_pending(TransactionType type, uint64_t address, uint64_t cycle, unsigned sourceId=0);
+	void read_complete(unsigned id, uint64_t address, uint64_t done_cycle);
+	void write_complete(unsigned id, uint64_t address, uint64_t done_cycle);
+
+	void setMeasuring(bool measuring);
+	void setBucketLength(uint64_t bucketLength);
+	void resetStats();
+	uint64_t getOutstanding() const;
+	uint64_t getOutstandingReads() const;
+	uint64_t getOutstandingReads(unsigned sourceId) const;
+	void printSourceStats(ostream &out) const;
+	void saveState(CheckpointWriter &checkpoint) const;
+	void restoreState(CheckpointReader &checkpoint);
+
+	//stats for the requests issued while measuring
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t totalReadLatency;
+	//measured requests issued while another source had one outstanding to the same address
+	uint64_t sharedAddressRequests;
+	uint64_t firstIssueCycle;
+	uint64_t lastDoneCycle;
+	//per source, indexed by sourceId; outstandingReads here counts measured or not
+	vector<SourceStats> sourceStats;
+
+	//only kept once setBucketLength() is called: all requests by issue
+	//cycle / bucketLength, and measured reads by latency / HISTOGRAM_BIN_SIZE
+	uint64_t bucketLength;
+	vector<BucketStats> buckets;
+	map<uint64_t, uint64_t> readLatencyHistogram;
+
+private:
+	BucketStats &getBucket(uint64_t issueCycle);
+};
+}
+
+#endif
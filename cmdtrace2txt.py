@@ -0,0 +1,90 @@
+#!/usr/bin/python
+"""
+
+Turns the binary command traces that DRAMSim writes when
+COMMAND_TRACE_OUTPUT=true (one per channel: VISFILE[.SIM_DESC].chN.cmdtrace
+when the vis file is named with -v, as it is for sweep variants and grid jobs,
+otherwise sim_out_DEVICE.ini[.SIM_DESC].chN.cmdtrace) into the modelsim text
+that VERIFICATION_OUTPUT writes to sim_out_DEVICE.ini[.SIM_DESC].tmp.
+
+The format (all little endian, as written by CommandTrace):
+
+  uint32 magic 'DSCT', uint32 version, uint32 channel
+  per command: uint64 cycle, uint32 row, uint32 column,
+               uint8 channel, uint8 rank, uint8 bank, uint8 command
+
+Given the traces of several channels, the commands are merged by cycle in
+channel order, the order in which VERIFICATION_OUTPUT interleaves them.
+
+Usage: ./cmdtrace2txt.py [-o OUTPUT.tmp] FILENAME.ch0.cmdtrace [FILENAME.ch1.cmdtrace ...]
+       (default: stdout)
+
+"""
+
+from __future__ import print_function
+
+import heapq
+import struct
+import sys
+from optparse import OptionParser
+
+MAGIC = 0x54435344
+VERSION = 1
+RECORD = struct.Struct('<QIIBBBB')
+
+# BusPacketType
+READ, READ_P, WRITE, WRITE_P, ACTIVATE, PRECHARGE, REFRESH = range(7)
+
+
+def read_cmdtrace(filename):
+	""" yields (cycle, channel, row, column, rank, bank, command) for every command """
+	data = open(filename, 'rb').read()
+	magic, version, channel = struct.unpack_from('<III', data, 0)
+	if magic != MAGIC:
+		sys.exit("%s is not a command trace" % filename)
+	if version != VERSION:
+		sys.exit("%s is version %d, only version %d is known" % (filename, version, VERSION))
+	offset = 12
+	# a run that was cut short may have left half a record at the end
+	while offset + RECORD.size <= len(data):
+		cycle, row, column, channel, rank, bank, command = RECORD.unpack_from(data, offset)
+		yield cycle, channel, row, column, rank, bank, command
+		offset += RECORD.size
+
+
+def sort_keys(records):
+	""" each trace is already in cycle order; numbering the records keeps
+	that order within a cycle when the traces are merged """
+	for n, record in enumerate(records):
+		yield (record[0], record[1], n), record
+
+
+def format_command(cycle, row, column, rank, bank, command):
+	""" the line BusPacket::print() writes for a command """
+	if command == READ:
+		return "%d: read (%d,%d,%d,0);" % (cycle, rank, bank, column)
+	if command == READ_P:
+		return "%d: read (%d,%d,%d,1);" % (cycle, rank, bank, column)
+	if command == WRITE:
+		return "%d: write (%d,%d,%d,0 , 0, 'h0);" % (cycle, rank, bank, column)
+	if command == WRITE_P:
+		return "%d: write (%d,%d,%d,1, 0, 'h0);" % (cycle, rank, bank, column)
+	if command == ACTIVATE:
+		return "%d: activate (%d,%d,%d);" % (cycle, rank, bank, row)
+	if command == PRECHARGE:
+		return "%d: precharge (%d,%d,%d);" % (cycle, rank, bank, row)
+	if command == REFRESH:
+		return "%d: refresh (%d);" % (cycle, rank)
+	sys.exit("Unknown command %d at cycle %d" % (command, cycle))
+
+
+if __name__ == '__main__':
+	parser = OptionParser(usage="%prog [-o OUTPUT] FILENAME.cmdtrace [FILENAME.cmdtrace ...]")
+	parser.add_option('-o', '--output', help="file to write the text to [default=stdout]")
+	(options, filenames) = parser.parse_args()
+	if not filenames:
+		parser.error("at least one command trace is needed")
+	out = open(options.output, 'w') if options.output else sys.stdout
+	merged = heapq.merge(*[sort_keys(read_cmdtrace(f)) for f in filenames])
+	for key, (cycle, channel, row, column, rank, bank, command) in merged:
+		out.write(format_command(cycle, row, column, rank, bank, command) + '\n')
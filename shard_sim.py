@@ -0,0 +1,225 @@
+#!/usr/bin/python
+"""
+
+Runs a multi-channel simulation as one DRAMSim process per channel and merges
+the results into a single report.
+
+With open loop trace replay the channels only interact through the order of
+the trace, so the trace can be split by channel (DRAMSim --split-trace, using
+the address mapping from the ini files) and every shard simulated on its own
+(DRAMSim --channel=N, which updates and reports only that channel). The
+merged stats and vis file are laid out the way a single run of all the
+channels would have written them. The numbers are close to but not exactly
+those of a single run: there a request that can't go out right away (its
+queue is full, or another request is due the same cycle) holds up the rest
+of the trace, including the other channels' requests.
+
+Usage:
+
+  ./shard_sim.py -t traces/k6_aoe_02_short.trc [-j 4] [-o shards] -- \\
+      -s system.ini -d ini/DDR3_micron_32M_8B_x4_sg125.ini -c 1000000 -o NUM_CHANS=4
+
+Everything after -- is passed to every DRAMSim process as is (so no -t, -v or
+closed loop options there). The shards and the output of each process go to
+the output directory along with TRACENAME.merged.txt (stats) and
+TRACENAME.merged.vis.
+
+  ./shard_sim.py --merge shards -t traces/k6_aoe_02_short.trc
+
+only redoes the merge of a finished run.
+
+"""
+
+from __future__ import print_function
+
+import glob
+import os
+import re
+import subprocess
+import sys
+import time
+from optparse import OptionParser
+
+STATS_START = re.compile(r'^ =+$')
+CHANNEL_START = re.compile(r'^==== Channel \[(\d+)\] ====$')
+CHANNEL_END = re.compile(r'^//// Channel \[\d+\] ////$')
+VIS_FILE = re.compile(r'^writing vis file to (.*)$')
+
+
+def shard_files(output_dir, trace_name):
+	""" the shards of a trace in channel order """
+	shards = glob.glob(os.path.join(output_dir, trace_name + '.ch*'))
+	shards = [s for s in shards if re.search(r'\.ch\d+$', s)]
+	return sorted(shards, key=lambda s: int(s[s.rindex('.ch')+3:]))
+
+
+def run_shards(options, dramsim_args):
+	trace_name = os.path.basename(options.tracefile)
+	split = [options.dramsim, '-t', options.tracefile, '--split-trace=' + options.output] + dramsim_args
+	print(' '.join(split))
+	if subprocess.call(split) != 0:
+		sys.exit("Splitting the trace failed")
+
+	shards = shard_files(options.output, trace_name)
+	running = []
+	failed = []
+	start = time.time()
+	for channel, shard in enumerate(shards):
+		while len(running) >= options.jobs:
+			failed += wait_for_one(running)
+		name = os.path.join(options.output, '%s.ch%d' % (trace_name, channel))
+		command = [options.dramsim, '-t', shard, '--channel=%d' % channel, '-v', name] + dramsim_args
+		print(' '.join(command))
+		stdout = open(name + '.txt', 'w')
+		stderr = open(name + '.err', 'w')
+		running.append((channel, subprocess.Popen(command, stdout=stdout, stderr=stderr)))
+	while running:
+		failed += wait_for_one(running)
+	print("== Ran %d shards in %.1f s ==" % (len(shards), time.time() - start))
+	if failed:
+		sys.exit("Shards %s failed, see their .err files" % ', '.join(str(c) for c in sorted(failed)))
+
+
+def wait_for_one(running):
+	""" waits for the oldest running shard, returns [its channel] if it failed """
+	channel, process = running.pop(0)
+	if process.wait() != 0:
+		return [channel]
+	return []
+
+
+def split_stats(lines):
+	""" cuts a stats output into what comes before the first stats block, the
+	blocks themselves (each one printStats() of one channel) and what comes
+	after the last one """
+	preamble = []
+	blocks = []
+	epilogue = []
+	current = None
+	for line in lines:
+		if CHANNEL_START.match(line) or (STATS_START.match(line) and not (current and CHANNEL_START.match(current[-1]))):
+			current = [line]
+			blocks.append(current)
+			epilogue = []
+		elif current is None:
+			preamble.append(line)
+		elif CHANNEL_END.match(line):
+			current.append(line)
+			current = epilogue
+		else:
+			current.append(line)
+	return preamble, blocks, epilogue
+
+
+def merge_stats(outputs):
+	""" interleaves the per-channel stats blocks of every shard """
+	split = [split_stats(lines) for lines in outputs]
+	merged = list(split[0][0])
+	for i in range(max(len(s[1]) for s in split)):
+		for preamble, blocks, epilogue in split:
+			if i < len(blocks):
+				merged += blocks[i]
+	for channel, (preamble, blocks, epilogue) in enumerate(split):
+		if epilogue:
+			merged.append('== Shard %d ==' % channel)
+			merged += epilogue
+	return merged
+
+
+def read_vis(filename):
+	""" returns (ini lines, epoch header, epoch rows, histogram lines) """
+	ini, header, rows, histogram = [], None, [], []
+	section = None
+	for line in open(filename):
+		line = line.rstrip('\n')
+		# the last row of a run and the histogram marker share a line
+		if '!!HISTOGRAM_DATA' in line and not line.startswith('!!'):
+			rows.append(line[:line.index('!!HISTOGRAM_DATA')].rstrip(',').split(','))
+			line = '!!HISTOGRAM_DATA'
+		if line.startswith('!!'):
+			section = line
+			if section != '!!EPOCH_DATA':
+				(histogram if section == '!!HISTOGRAM_DATA' else ini).append(line)
+			continue
+		if section == '!!EPOCH_DATA':
+			if header is None:
+				header = line.rstrip(',').split(',')
+			elif line:
+				rows.append(line.rstrip(',').split(','))
+		elif section == '!!HISTOGRAM_DATA':
+			histogram.append(line)
+		else:
+			ini.append(line)
+	return ini, header or ['ms'], rows, histogram
+
+
+def merge_vis(vis_files, merged_filename):
+	""" puts the columns of every shard (all but the leading ms) side by side """
+	shards = [read_vis(f) for f in vis_files]
+	out = open(merged_filename, 'w')
+	for line in shards[0][0]:
+		out.write(line + '\n')
+	out.write('!!EPOCH_DATA\n')
+	header = ['ms']
+	for ini, shard_header, rows, histogram in shards:
+		header += shard_header[1:]
+	out.write(','.join(header) + ',\n')
+	# a shard run to completion may stop a few epochs before the others
+	for i in range(max(len(s[2]) for s in shards)):
+		ms = ''
+		row = []
+		for ini, shard_header, rows, histogram in shards:
+			values = rows[i] if i < len(rows) else [''] * len(shard_header)
+			ms = ms or values[0]
+			row += values[1:]
+		out.write(','.join([ms] + row) + ',\n')
+	for ini, shard_header, rows, histogram in shards:
+		for line in histogram:
+			out.write(line + '\n')
+	out.close()
+
+
+def merge(options):
+	trace_name = os.path.basename(options.tracefile)
+	channels = len(shard_files(options.output, trace_name))
+	if channels == 0:
+		sys.exit("No shards of %s in %s" % (trace_name, options.output))
+	names = [os.path.join(options.output, '%s.ch%d' % (trace_name, c)) for c in range(channels)]
+
+	outputs = [open(name + '.txt').read().splitlines() for name in names]
+	merged_stats = os.path.join(options.output, trace_name + '.merged.txt')
+	out = open(merged_stats, 'w')
+	for line in merge_stats(outputs):
+		out.write(line + '\n')
+	out.close()
+	print("== Merged stats of %d channels into %s ==" % (channels, merged_stats))
+
+	vis_files = []
+	for name in names:
+		for line in open(name + '.err'):
+			match = VIS_FILE.match(line.rstrip('\n'))
+			if match:
+				vis_files.append(match.group(1))
+	if len(vis_files) == channels:
+		merged_vis = os.path.join(options.output, trace_name + '.merged.vis')
+		merge_vis(vis_files, merged_vis)
+		print("== Merged vis files into %s ==" % merged_vis)
+	elif vis_files:
+		print("Only %d of %d shards wrote a vis file, not merging them" % (len(vis_files), channels))
+
+
+if __name__ == '__main__':
+	parser = OptionParser(usage="%prog -t TRACEFILE [options] -- DRAMSIM_ARGS")
+	parser.add_option('-t', '--tracefile', help="trace to split and run")
+	parser.add_option('-o', '--output', default='shards', help="directory for the shards and their output [default=%default]")
+	parser.add_option('-j', '--jobs', type='int', default=os.sysconf('SC_NPROCESSORS_ONLN'), help="shards run at the same time [default=number of CPUs]")
+	parser.add_option('-b', '--dramsim', default='./DRAMSim', help="DRAMSim binary [default=%default]")
+	parser.add_option('--merge', metavar='DIRECTORY', help="only merge the output of a finished run in DIRECTORY")
+	(options, dramsim_args) = parser.parse_args()
+	if not options.tracefile:
+		parser.error("a tracefile is needed (-t)")
+	if options.merge:
+		options.output = options.merge
+	else:
+		run_shards(options, dramsim_args)
+	merge(options)
@@ -0,0 +1,67 @@
+#!/usr/bin/python
+"""
+
+Converts the binary epoch data that DRAMSim writes next to the vis file when
+VIS_FILE_BINARY=true (FILENAME.visb) back into the CSV rows of the vis file's
+!!EPOCH_DATA section.
+
+The format (all little endian, as written by CSVWriter):
+
+  uint32 magic 'DSVB', uint32 version, uint32 number of columns
+  per column: uint32 length, then the name
+  per row: one double per column
+
+Usage: ./visb2csv.py FILENAME.visb [OUTPUT.csv]    (default: stdout)
+
+"""
+
+from __future__ import print_function
+
+import math
+import struct
+import sys
+
+MAGIC = 0x42565344
+VERSION = 1
+
+
+def read_visb(filename):
+	""" returns (column names, list of rows) """
+	data = open(filename, 'rb').read()
+	magic, version, columns = struct.unpack_from('<III', data, 0)
+	if magic != MAGIC:
+		sys.exit("%s is not a binary vis file" % filename)
+	if version != VERSION:
+		sys.exit("%s is version %d, only version %d is known" % (filename, version, VERSION))
+	offset = 12
+	names = []
+	for i in range(columns):
+		(length,) = struct.unpack_from('<I', data, offset)
+		offset += 4
+		names.append(data[offset:offset+length].decode('ascii'))
+		offset += length
+	row_format = '<%dd' % columns
+	row_size = struct.calcsize(row_format)
+	rows = []
+	# a run that was cut short may have left half a row at the end
+	while offset + row_size <= len(data):
+		rows.append(struct.unpack_from(row_format, data, offset))
+		offset += row_size
+	return names, rows
+
+
+def format_value(value):
+	""" the way the vis file prints a number (printf %g, which keeps the sign of a nan) """
+	if value != value:
+		return '-nan' if math.copysign(1.0, value) < 0 else 'nan'
+	return '%g' % value
+
+
+if __name__ == '__main__':
+	if len(sys.argv) not in (2, 3):
+		sys.exit("Usage: %s FILENAME.visb [OUTPUT.csv]" % sys.argv[0])
+	names, rows = read_visb(sys.argv[1])
+	out = open(sys.argv[2], 'w') if len(sys.argv) == 3 else sys.stdout
+	out.write(','.join(names) + ',\n')
+	for row in rows:
+		out.write(','.join(format_value(v) for v in row) + ',\n')